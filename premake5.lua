@@ -5,6 +5,11 @@ end
 
 local TARGET_DIR = ".bin/%{cfg.buildcfg}"
 
+newoption {
+	trigger = "avx2",
+	description = "Build with AVX2 enabled, the particle kernels then use 8 wide vectors"
+}
+
 local SRC_DIR = "src"
 local LIB_DIR = "lib"
 local ENTT_DIR = path.join(LIB_DIR, "entt")
@@ -32,6 +37,9 @@ solution "RayTest"
 	filter "platforms:x86_64"
 		architecture "x86_64"
 	filter {}
+	if _OPTIONS["avx2"] ~= nil then
+		vectorextensions "AVX2"
+	end
 
 project "Game"
 	kind "WindowedApp"
@@ -47,6 +55,7 @@ project "Game"
 		RAYGUI_DIR .. "/src/**.c",
 		TRACY_DIR .. "/TracyClient.cpp"
 	}
+	removefiles {"src/SimBench/**"}
 
 	includedirs {SRC_DIR}
 
@@ -82,6 +91,42 @@ project "Game"
 		"{COPYFILE} %[resources/*.*] %[%{!cfg.targetdir}/resources/*.*]"
 	}
 
+-- Headless simulation benchmark, raylib is only used for its math headers
+project "SimBench"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++20"
+	exceptionhandling "Off"
+	rtti "Off"
+	files {
+		"src/SimBench/**.cpp",
+		"src/Simulation/**.cpp",
+		"src/Simulation/**.h",
+		"src/ThreadPool/**.cpp",
+		"src/ThreadPool/**.h",
+		"src/Components.h",
+		"src/Data.h",
+		"src/DependencyContainer.h",
+		"src/RenderSnapshot.h",
+		"src/SpatialPartition.h",
+		TRACY_DIR .. "/TracyClient.cpp"
+	}
+
+	includedirs {SRC_DIR}
+
+	includedirs {ENTT_DIR .. "/src"}
+
+	includedirs {RAYLIB_DIR .. "/src"}
+
+	includedirs {TRACY_DIR }
+	filter "configurations:Profile"
+		defines {"TRACY_ENABLE"}
+	filter "system:linux"
+		links {"pthread"}
+	filter "system:Windows"
+		defines{"_WIN32"}
+	filter{}
+
 -- Older versions of premake can't handle "None" project types for gmake2
 if _TARGET_OS ~= "linux" then
 	include "entt-premake5.lua"
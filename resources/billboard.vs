@@ -0,0 +1,27 @@
+#version 330
+
+// Input vertex attributes
+in vec2 vertexTexCoord; // Quad corner, shared by all instances
+in vec3 instancePosition;
+in vec4 instanceColor;
+
+// Input uniform values
+uniform mat4 mvp;
+uniform vec3 cameraRight;
+uniform vec3 cameraUp;
+uniform vec2 size;
+
+// Output vertex attributes (to fragment shader)
+out vec2 fragTexCoord;
+out vec4 fragColor;
+
+void main()
+{
+    fragTexCoord = vertexTexCoord;
+    fragColor = instanceColor;
+
+    // Quad centered on the instance, facing the camera
+    vec2 corner = (vertexTexCoord - 0.5)*size;
+    vec3 position = instancePosition + cameraRight*corner.x + cameraUp*corner.y;
+    gl_Position = mvp*vec4(position, 1.0);
+}
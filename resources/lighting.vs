@@ -5,11 +5,11 @@ in vec3 vertexPosition;
 in vec2 vertexTexCoord;
 in vec3 vertexNormal;
 in vec4 vertexColor;
+// Per instance model transform, drawn with DrawMeshInstanced
+in mat4 instanceTransform;
 
 // Input uniform values
 uniform mat4 mvp;
-uniform mat4 matModel;
-uniform mat4 matNormal;
 
 // Output vertex attributes (to fragment shader)
 out vec3 fragPosition;
@@ -22,11 +22,13 @@ out vec3 fragNormal;
 void main()
 {
     // Send vertex attributes to fragment shader
-    fragPosition = vec3(matModel*vec4(vertexPosition, 1.0));
+    vec4 worldPosition = instanceTransform*vec4(vertexPosition, 1.0);
+    fragPosition = vec3(worldPosition);
     fragTexCoord = vertexTexCoord;
     fragColor = vertexColor;
-    fragNormal = normalize(vec3(matNormal*vec4(vertexNormal, 1.0)));
+    // Uniform scale, the model matrix itself keeps normals perpendicular
+    fragNormal = normalize(mat3(instanceTransform)*vertexNormal);
 
-    // Calculate final vertex position
-    gl_Position = mvp*vec4(vertexPosition, 1.0);
+    // Calculate final vertex position, mvp only holds view and projection
+    gl_Position = mvp*worldPosition;
 }
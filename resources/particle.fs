@@ -0,0 +1,17 @@
+#version 330
+
+// Input vertex attributes (from vertex shader)
+in vec4 fragColor;
+
+// Output fragment color
+out vec4 finalColor;
+
+void main()
+{
+    // Round sprite
+    vec2 offset = gl_PointCoord*2.0 - 1.0;
+    if (dot(offset, offset) > 1.0) {
+        discard;
+    }
+    finalColor = fragColor;
+}
@@ -0,0 +1,20 @@
+#version 330
+
+// Input vertex attributes
+in vec3 vertexPosition;
+in vec4 vertexColor;
+
+// Input uniform values
+uniform mat4 mvp;
+uniform float pointScale; // Pixels covered by one world unit at unit depth
+
+// Output vertex attributes (to fragment shader)
+out vec4 fragColor;
+
+void main()
+{
+    fragColor = vertexColor;
+    gl_Position = mvp*vec4(vertexPosition, 1.0);
+    // Perspective size, never thinner than a pixel
+    gl_PointSize = max(pointScale/gl_Position.w, 1.0);
+}
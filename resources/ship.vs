@@ -0,0 +1,27 @@
+#version 330
+
+// Input vertex attributes
+in vec3 vertexPosition;
+in vec3 instancePosition;
+in vec4 instanceRotation; // Unit quaternion, xyz then w
+in vec4 instanceColor;
+
+// Input uniform values
+uniform mat4 mvp;
+uniform vec4 fillColor;
+uniform int wire; // Wire pass takes the instance color, fill pass the shared one
+
+// Output vertex attributes (to fragment shader)
+out vec4 fragColor;
+
+vec3 rotate(vec4 q, vec3 v)
+{
+    return v + 2.0*cross(q.xyz, cross(q.xyz, v) + q.w*v);
+}
+
+void main()
+{
+    fragColor = (wire != 0) ? instanceColor : fillColor;
+    vec3 position = instancePosition + rotate(instanceRotation, vertexPosition);
+    gl_Position = mvp*vec4(position, 1.0);
+}
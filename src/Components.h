@@ -68,9 +68,6 @@ struct ParticleComponent
 struct BulletComponent
 {};
 
-struct ParticleDragComponent
-{};
-
 struct DestroyComponent
 {};
 
@@ -93,6 +90,12 @@ struct ParticleCollisionComponent
     entt::entity Collider;
 };
 
+// Slot of the entity in the incremental spatial partition
+struct PartitionProxyComponent
+{
+    uint32_t Handle;
+};
+
 struct ExplosionComponent
 {
     float StartTime;
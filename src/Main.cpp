@@ -3,16 +3,16 @@
 #include "DependencyContainer.h"
 #include "Menu.h"
 #include "Render/Render.h"
+#include "Simulation/Replay.h"
 #include "Simulation/Simulation.h"
+#include "TripleBuffer.h"
 #include <tracy/Tracy.hpp>
 #include "entt/entt.hpp"
 #include "raylib.h"
 #include "raymath.h"
 #include "rcamera.h"
 #include <Render/RenderLists.h>
-#include <mutex>
-#include <queue>
-#include <stack>
+#include <cstring>
 #include <stop_token>
 #include <thread>
 
@@ -100,25 +100,18 @@ static void SetCameraUp(Camera& camera)
     Vector3Normalize(Vector3CrossProduct(Vector3CrossProduct(toTarget, {0.f, 1.f, 0.f}), toTarget));
 }
 
-static void UpdateCameras(entt::registry& registry, GameCameras& gameCameras)
+static void UpdateCameras(const RenderSnapshot& snapshot, GameCameras& gameCameras)
 {
     ZoneScopedN("Update Cameras");
-    for (auto playerEntity : registry.view<PositionComponent, SpaceshipInputComponent>()) {
-        const auto& input = registry.get<SpaceshipInputComponent>(playerEntity);
-        auto& position = registry.get<PositionComponent>(playerEntity);
-        const Vector3 target = Vector3Add(position.Position, CameraData::TargetOffset);
-        gameCameras[input.InputId].target = target;
-        gameCameras[input.InputId].position = Vector3Add(target, CameraData::CameraOffset);
+    for (const RenderSnapshot::Spaceship& spaceship : snapshot.Spaceships) {
+        const Vector3 target = Vector3Add(spaceship.Position, CameraData::TargetOffset);
+        gameCameras[spaceship.InputId].target = target;
+        gameCameras[spaceship.InputId].position = Vector3Add(target, CameraData::CameraOffset);
     }
-    for (auto playerEntity : registry.view<PositionComponent, RespawnComponent>()) {
-        const auto& respawn = registry.get<RespawnComponent>(playerEntity);
-        if (respawn.TimeLeft > 0.f) {
-            continue;
-        }
-        auto& position = registry.get<PositionComponent>(playerEntity);
-        const Vector3 target = Vector3Add(position.Position, CameraData::TargetOffset);
-        gameCameras[respawn.InputId].target = target;
-        gameCameras[respawn.InputId].position = Vector3Add(target, CameraData::CameraOffset);
+    for (const RenderSnapshot::Respawner& respawner : snapshot.Respawners) {
+        const Vector3 target = Vector3Add(respawner.Position, CameraData::TargetOffset);
+        gameCameras[respawner.InputId].target = target;
+        gameCameras[respawner.InputId].position = Vector3Add(target, CameraData::CameraOffset);
     }
 
     for (Camera& camera : gameCameras) {
@@ -126,8 +119,20 @@ static void UpdateCameras(entt::registry& registry, GameCameras& gameCameras)
     }
 }
 
-int main()
+// Game [--record PATH]: PATH gets the input log of the last started game, for SimBench --replay
+static const char* RecordPath(int argc, char** argv)
 {
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::strcmp(argv[i], "--record") == 0) {
+            return argv[i + 1];
+        }
+    }
+    return nullptr;
+}
+
+int main(int argc, char** argv)
+{
+    const char* recordPath = RecordPath(argc, argv);
     SetupWindow();
     auto gameInput = std::make_shared<std::array<GameInput, MaxViews>>();
     auto gameCameras = std::make_shared<GameCameras>();
@@ -139,8 +144,19 @@ int main()
     entt::registry& simRegistry = simDependencies.CreateDependency<entt::registry>();
     simDependencies.AddDependency(gameInput); // This should be owned elsewhere
 
-    std::unique_ptr<Simulation> sim = std::make_unique<Simulation>(simDependencies);
-    sim->Init(0);
+    std::unique_ptr<Simulation> sim;
+    ReplayRecorder recorder;
+    auto initSimulation = [&](uint32_t players) {
+        sim = std::make_unique<Simulation>(simDependencies);
+        sim->Init(players);
+        if (recordPath != nullptr) {
+            const ReplayHeader header = ReplayHeader::FromSettings(sim->Settings, players, SpaceData::AsteroidsCount);
+            if (!recorder.Open(recordPath, header)) {
+                TraceLog(LOG_WARNING, "Cannot write replay %s", recordPath);
+            }
+        }
+    };
+    initSimulation(0);
 
     RenderDependencies renderDependencies;
     renderDependencies.AddDependency(gameCameras);
@@ -151,15 +167,7 @@ int main()
 
     Menu menu;
 
-    std::mutex transferMutex;
-    std::array<entt::registry, 2> simSnapShots;
-    std::stack<uint32_t> writeReadySnapshots;
-    std::queue<uint32_t> presentReadySnapshots;
-
-    uint32_t renderSnapshotId = 1;
-    writeReadySnapshots.push(0);
-
-    std::condition_variable presentCondition;
+    TripleBuffer<RenderSnapshot> simSnapshots;
 
     auto simThreadProcess = [&](std::stop_token sToken) {
         double gameStartTime = GetTime();
@@ -168,22 +176,14 @@ int main()
             UpdateInput(*gameCameras, *gameInput);
             sim->Tick();
             simTicks += 1;
-
-            uint32_t snapshotId = simSnapShots.size();
-            if (!writeReadySnapshots.empty()) {
-                std::scoped_lock lock(transferMutex);
-                snapshotId = writeReadySnapshots.top();
-                writeReadySnapshots.pop();
+            if (recorder.IsOpen() && !recorder.Record(*gameInput, sim->StateHash())) {
+                TraceLog(LOG_WARNING, "Cannot write replay %s, recording stopped", recordPath);
             }
 
-            if (snapshotId < simSnapShots.size()) {
-                sim->WriteRenderState(simSnapShots[snapshotId]);
-                {
-                    std::scoped_lock lock(transferMutex);
-                    presentReadySnapshots.push(snapshotId);
-                }
-                presentCondition.notify_one();
-            }
+            RenderSnapshot& snapshot = simSnapshots.WriteBuffer();
+            sim->WriteRenderState(snapshot);
+            snapshot.PublishTime = GetTime();
+            simSnapshots.Publish();
 
             double gameTime = gameStartTime + SimTimeData::DeltaTime * simTicks;
             if (auto waitTime = gameTime - GetTime(); waitTime > 0.0) {
@@ -195,29 +195,19 @@ int main()
     };
 
     auto presentThreadProcess = [&](std::stop_token sToken) {
-        RenderLists pendingList;
         while (!sToken.stop_requested()) {
             {
                 ZoneScopedNC("Wait", 0x7777AAFF);
-                std::unique_lock lock(transferMutex);
-                presentCondition.wait(lock, [&]() {
-                    return sToken.stop_requested() || !presentReadySnapshots.empty();
-                });
-                if (presentReadySnapshots.empty()) {
+                if (!simSnapshots.WaitAcquire(sToken)) {
                     continue;
                 }
-                renderSnapshotId = presentReadySnapshots.front();
-                presentReadySnapshots.pop();
             }
-            UpdateCameras(simSnapShots[renderSnapshotId], *gameCameras);
-            while (!render->TryStartRenderTasks(simSnapShots[renderSnapshotId]) && !sToken.stop_requested()) {
+            const RenderSnapshot& snapshot = simSnapshots.ReadBuffer();
+            TracyPlot("Snapshot Latency (ms)", 1000.0 * (GetTime() - snapshot.PublishTime));
+            UpdateCameras(snapshot, *gameCameras);
+            while (!render->TryStartRenderTasks(snapshot) && !sToken.stop_requested()) {
                 std::this_thread::sleep_for(std::chrono::duration<float>(0.001f));
             }
-            simSnapShots[renderSnapshotId].clear();
-            {
-                std::scoped_lock lock(transferMutex);
-                writeReadySnapshots.push(renderSnapshotId);
-            }
         }
     };
 
@@ -227,11 +217,10 @@ int main()
     auto startGameAction = [&](uint32_t players) {
         simThread.reset();
         presentThread->request_stop();
-        presentCondition.notify_all();
+        simSnapshots.Interrupt();
         presentThread.reset();
 
-        sim = std::make_unique<Simulation>(simDependencies);
-        sim->Init(players);
+        initSimulation(players);
         SetViewports(players, *viewPorts);
         render = std::make_unique<Render>(players, renderDependencies);
 
@@ -256,7 +245,7 @@ int main()
 
     simThread.reset();
     presentThread->request_stop();
-    presentCondition.notify_all();
+    simSnapshots.Interrupt();
     presentThread.reset();
 
     CloseWindow();
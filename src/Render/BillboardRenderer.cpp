@@ -0,0 +1,82 @@
+#include "BillboardRenderer.h"
+#include "VertexAttribute.h"
+
+#include <array>
+#include <cstddef>
+#include <external/glad.h>
+#include <raymath.h>
+#include <rlgl.h>
+#include <tracy/Tracy.hpp>
+
+namespace {
+constexpr size_t MinCapacity = 1024;
+// Triangle strip over the unit square, also the texture coordinates
+constexpr std::array<Vector2, 4> QuadCorners = {Vector2{0.f, 0.f}, Vector2{1.f, 0.f}, Vector2{0.f, 1.f},
+                                                Vector2{1.f, 1.f}};
+} // namespace
+
+BillboardRenderer::BillboardRenderer() : mInstanceBuffer(MinCapacity * sizeof(BulletInstance))
+{
+    mShader = LoadShader("resources/billboard.vs", "resources/billboard.fs");
+    mCameraRightLoc = GetShaderLocation(mShader, "cameraRight");
+    mCameraUpLoc = GetShaderLocation(mShader, "cameraUp");
+    mSizeLoc = GetShaderLocation(mShader, "size");
+
+    glGenVertexArrays(1, &mVertexArray);
+    glGenBuffers(1, &mCornerBuffer);
+    glBindVertexArray(mVertexArray);
+
+    glBindBuffer(GL_ARRAY_BUFFER, mCornerBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(QuadCorners), QuadCorners.data(), GL_STATIC_DRAW);
+    EnableVertexAttribute(mShader.locs[SHADER_LOC_VERTEX_TEXCOORD01], 2, GL_FLOAT, false, sizeof(Vector2), 0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, mInstanceBuffer.Id());
+    EnableVertexAttribute(GetShaderLocationAttrib(mShader, "instancePosition"), 3, GL_FLOAT, false,
+                          sizeof(BulletInstance), offsetof(BulletInstance, Position), 1);
+    EnableVertexAttribute(GetShaderLocationAttrib(mShader, "instanceColor"), 4, GL_UNSIGNED_BYTE, true,
+                          sizeof(BulletInstance), offsetof(BulletInstance, Color), 1);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+BillboardRenderer::~BillboardRenderer()
+{
+    glDeleteBuffers(1, &mCornerBuffer);
+    glDeleteVertexArrays(1, &mVertexArray);
+    UnloadShader(mShader);
+}
+
+void BillboardRenderer::Draw(const std::vector<BulletInstance>& instances,
+                             const Camera& camera,
+                             const Texture& texture,
+                             const Vector2& size)
+{
+    ZoneScoped;
+    // The default shader LoadShader falls back to has no instance attributes
+    if (instances.empty() || mShader.id == rlGetShaderIdDefault()) {
+        return;
+    }
+    mInstanceBuffer.Upload(instances);
+
+    // The basis is computed once for all instances
+    const Matrix view = rlGetMatrixModelview();
+    const Vector3 right = {view.m0, view.m4, view.m8};
+    const Matrix mvp = MatrixMultiply(view, rlGetMatrixProjection());
+    rlEnableShader(mShader.id);
+    rlSetUniformMatrix(mShader.locs[SHADER_LOC_MATRIX_MVP], mvp);
+    rlSetUniform(mCameraRightLoc, &right, RL_SHADER_UNIFORM_VEC3, 1);
+    rlSetUniform(mCameraUpLoc, &camera.up, RL_SHADER_UNIFORM_VEC3, 1);
+    rlSetUniform(mSizeLoc, &size, RL_SHADER_UNIFORM_VEC2, 1);
+    const int textureSlot = 0;
+    rlSetUniform(mShader.locs[SHADER_LOC_MAP_DIFFUSE], &textureSlot, RL_SHADER_UNIFORM_SAMPLER2D, 1);
+    rlActiveTextureSlot(textureSlot);
+    rlEnableTexture(texture.id);
+
+    glBindVertexArray(mVertexArray);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, static_cast<GLsizei>(QuadCorners.size()),
+                          static_cast<GLsizei>(instances.size()));
+    glBindVertexArray(0);
+    rlDisableTexture();
+    rlDisableShader();
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "RenderLists.h"
+#include "StreamedBuffer.h"
+#include <raylib.h>
+#include <stdint.h>
+#include <vector>
+
+// Draws textured, camera facing quads in one instanced call. Instances (position, color) are streamed every draw,
+// the quad corners are a static buffer shared by all of them and the vertex shader expands the quads with the same
+// basis DrawBillboardPro uses: the camera's right vector and its up vector.
+class BillboardRenderer final
+{
+public:
+    BillboardRenderer();
+    ~BillboardRenderer();
+    BillboardRenderer(const BillboardRenderer&) = delete;
+    BillboardRenderer& operator=(const BillboardRenderer&) = delete;
+
+    // Between BeginMode3D and EndMode3D, under whatever blend mode is active
+    void Draw(const std::vector<BulletInstance>& instances,
+              const Camera& camera,
+              const Texture& texture,
+              const Vector2& size);
+
+private:
+    Shader mShader;
+    int mCameraRightLoc;
+    int mCameraUpLoc;
+    int mSizeLoc;
+    uint32_t mVertexArray = 0;
+    uint32_t mCornerBuffer = 0;
+    StreamedBuffer mInstanceBuffer;
+};
@@ -0,0 +1,59 @@
+#include "ParticleRenderer.h"
+#include "VertexAttribute.h"
+
+#include <cmath>
+#include <cstddef>
+#include <external/glad.h>
+#include <raymath.h>
+#include <rlgl.h>
+#include <tracy/Tracy.hpp>
+
+namespace {
+constexpr float ParticleSize = 0.1f; // World units
+constexpr size_t MinCapacity = 16384;
+} // namespace
+
+ParticleRenderer::ParticleRenderer() : mVertexBuffer(MinCapacity * sizeof(ParticleVertex))
+{
+    mShader = LoadShader("resources/particle.vs", "resources/particle.fs");
+    mPointScaleLoc = GetShaderLocation(mShader, "pointScale");
+
+    glGenVertexArrays(1, &mVertexArray);
+    glBindVertexArray(mVertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, mVertexBuffer.Id());
+    EnableVertexAttribute(mShader.locs[SHADER_LOC_VERTEX_POSITION], 3, GL_FLOAT, false, sizeof(ParticleVertex),
+                          offsetof(ParticleVertex, Position));
+    EnableVertexAttribute(mShader.locs[SHADER_LOC_VERTEX_COLOR], 4, GL_UNSIGNED_BYTE, true, sizeof(ParticleVertex),
+                          offsetof(ParticleVertex, Color));
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+ParticleRenderer::~ParticleRenderer()
+{
+    glDeleteVertexArrays(1, &mVertexArray);
+    UnloadShader(mShader);
+}
+
+void ParticleRenderer::Draw(const std::vector<ParticleVertex>& particles, const Camera& camera, float viewportHeight)
+{
+    ZoneScoped;
+    // LoadShader falls back to the default shader, which doesn't take point sprites
+    if (particles.empty() || mShader.id == rlGetShaderIdDefault()) {
+        return;
+    }
+    mVertexBuffer.Upload(particles);
+
+    const Matrix mvp = MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection());
+    const float pointScale = ParticleSize * viewportHeight / (2.f * std::tan(camera.fovy * DEG2RAD * 0.5f));
+    rlEnableShader(mShader.id);
+    rlSetUniformMatrix(mShader.locs[SHADER_LOC_MATRIX_MVP], mvp);
+    rlSetUniform(mPointScaleLoc, &pointScale, RL_SHADER_UNIFORM_FLOAT, 1);
+
+    glEnable(GL_PROGRAM_POINT_SIZE);
+    glBindVertexArray(mVertexArray);
+    glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(particles.size()));
+    glBindVertexArray(0);
+    glDisable(GL_PROGRAM_POINT_SIZE);
+    rlDisableShader();
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "RenderLists.h"
+#include "StreamedBuffer.h"
+#include <raylib.h>
+#include <stdint.h>
+#include <vector>
+
+// Draws the particles of a view as round point sprites in one GL_POINTS call, the whole list streamed into a single
+// vertex buffer.
+// Needs a GL 3.3 context, which Mesa's llvmpipe (LIBGL_ALWAYS_SOFTWARE=1) provides.
+class ParticleRenderer final
+{
+public:
+    ParticleRenderer();
+    ~ParticleRenderer();
+    ParticleRenderer(const ParticleRenderer&) = delete;
+    ParticleRenderer& operator=(const ParticleRenderer&) = delete;
+
+    // Between BeginMode3D and EndMode3D, viewportHeight in pixels
+    void Draw(const std::vector<ParticleVertex>& particles, const Camera& camera, float viewportHeight);
+
+private:
+    Shader mShader;
+    int mPointScaleLoc;
+    uint32_t mVertexArray = 0;
+    StreamedBuffer mVertexBuffer;
+};
@@ -55,61 +55,6 @@ CameraFrustum ComputeFrustum(const Camera& camera, const CameraRays& cameraRays)
 
 constexpr Color SpaceColor = {40, 40, 50, 255};
 
-void DrawSpaceShip(const Vector3& position, const Quaternion& orientation, const Color color)
-{
-    constexpr float scale = 0.65f;
-
-    std::array<Vector3, 7> vertices = {
-    Vector3{0.f, 0.f, 2.f * scale},               // 0 : nose
-    Vector3{-1.25f * scale, 0.f, -scale},         // 1 : wingL
-    Vector3{1.25f * scale, 0.f, -scale},          // 2 : wingR
-    Vector3{0.f, 0.f, 0.f},                       // 3 : center
-    Vector3{0.f, 0.f, -scale},                    // 4 : tail
-    Vector3{0.f, scale * 1.5f, -1.5f * scale},    // 5 : finT
-    Vector3{0.f, -0.75f * scale, -0.75f * scale}, // 6 : finB
-    };
-
-    constexpr std::array<std::array<int, 3>, 3> triangles = {std::array<int, 3>{0, 1, 2},
-                                                             std::array<int, 3>{3, 4, 5},
-                                                             std::array<int, 3>{0, 4, 6}};
-
-    for (Vector3& vertex : vertices) {
-        vertex = Vector3RotateByQuaternion(vertex, orientation);
-    }
-
-    for (Vector3& vertex : vertices) {
-        vertex += position;
-    }
-
-    rlBegin(RL_TRIANGLES);
-    rlColor4ub(SpaceColor.r, SpaceColor.g, SpaceColor.b, SpaceColor.a);
-
-    for (const auto& triangle : triangles) {
-        rlVertex3f(vertices[triangle[0]].x, vertices[triangle[0]].y, vertices[triangle[0]].z);
-        rlVertex3f(vertices[triangle[1]].x, vertices[triangle[1]].y, vertices[triangle[1]].z);
-        rlVertex3f(vertices[triangle[2]].x, vertices[triangle[2]].y, vertices[triangle[2]].z);
-
-        rlVertex3f(vertices[triangle[2]].x, vertices[triangle[2]].y, vertices[triangle[2]].z);
-        rlVertex3f(vertices[triangle[1]].x, vertices[triangle[1]].y, vertices[triangle[1]].z);
-        rlVertex3f(vertices[triangle[0]].x, vertices[triangle[0]].y, vertices[triangle[0]].z);
-    }
-    rlEnd();
-
-    rlBegin(RL_LINES);
-    rlColor4ub(color.r, color.g, color.b, color.a);
-    for (const auto& triangle : triangles) {
-        rlVertex3f(vertices[triangle[0]].x, vertices[triangle[0]].y, vertices[triangle[0]].z);
-        rlVertex3f(vertices[triangle[1]].x, vertices[triangle[1]].y, vertices[triangle[1]].z);
-        rlVertex3f(vertices[triangle[1]].x, vertices[triangle[1]].y, vertices[triangle[1]].z);
-        rlVertex3f(vertices[triangle[2]].x, vertices[triangle[2]].y, vertices[triangle[2]].z);
-        rlVertex3f(vertices[triangle[2]].x, vertices[triangle[2]].y, vertices[triangle[2]].z);
-        rlVertex3f(vertices[triangle[0]].x, vertices[triangle[0]].y, vertices[triangle[0]].z);
-    }
-    rlEnd();
-}
-
-const std::array<Color, 2> PlayerColors = {RED, BLUE};
-
 void DrawRespawns(const RenderLists& lists)
 {
     ZoneScoped;
@@ -121,12 +66,10 @@ void DrawRespawns(const RenderLists& lists)
     }
 }
 
-void DrawSpaceships(const RenderLists& lists)
+void DrawSpaceships(const RenderLists& lists, ShipRenderer& renderer)
 {
     ZoneScoped;
-    for (const auto& [position, orientation, inputID] : lists.Spaceships) {
-        DrawSpaceShip(position, orientation, PlayerColors[inputID]);
-    }
+    renderer.Draw(lists.Spaceships, SpaceColor);
 }
 
 void DrawExplosions(const RenderLists& lists)
@@ -138,21 +81,14 @@ void DrawExplosions(const RenderLists& lists)
     }
 }
 
-void DrawBullets(const Camera& camera, const Texture& glow, const RenderLists& lists)
+void DrawBullets(const Camera& camera, const Texture& glow, const RenderLists& lists, BillboardRenderer& renderer)
 {
     ZoneScoped;
 
     BeginBlendMode(BLEND_ADDITIVE);
 
-    const Rectangle source = {0.0f, 0.0f, (float)glow.width, (float)glow.height};
     const Vector2 size = {1.5f, 1.5f};
-
-    const Vector3 toTarget = Vector3Subtract(camera.target, camera.position);
-    const Vector3 up = camera.up;
-
-    for (const auto& [position, color] : lists.Bullets) {
-        DrawBillboardPro(camera, glow, source, position, up, size, Vector2Scale(size, 0.5f), 0.f, color);
-    }
+    renderer.Draw(lists.Bullets, camera, glow, size);
 
     EndBlendMode();
 }
@@ -163,16 +99,10 @@ void DrawAsteroids(const RenderLists& lists, const Model& asteroidModel, Shader&
 
     SetShaderValue(shader, shader.locs[SHADER_LOC_VECTOR_VIEW], &camera.position.x, SHADER_UNIFORM_VEC3);
 
-    for (const auto& [position, radius] : lists.Asteroids) {
-        DrawModel(asteroidModel, position, radius, GRAY);
-    }
-}
-
-void DrawParticles(const RenderLists& lists)
-{
-    ZoneScoped;
-    for (const auto& [position, color] : lists.Particles) {
-        DrawPoint3D(position, color);
+    // A single draw call covers every foreground, background and wrapped copy in the view
+    if (!lists.AsteroidTransforms.empty()) {
+        DrawMeshInstanced(asteroidModel.meshes[0], asteroidModel.materials[0], lists.AsteroidTransforms.data(),
+                          static_cast<int>(lists.AsteroidTransforms.size()));
     }
 }
 
@@ -185,6 +115,8 @@ Vector3 BackgroundOffset(const Camera& camera)
 void SetShader(Shader& shader)
 {
     shader.locs[SHADER_LOC_VECTOR_VIEW] = GetShaderLocation(shader, "viewPos");
+    // DrawMeshInstanced feeds the instance transforms to the attribute at the model matrix location
+    shader.locs[SHADER_LOC_MATRIX_MODEL] = GetShaderLocationAttrib(shader, "instanceTransform");
 
     int ambientLoc = GetShaderLocation(shader, "ambient");
     const float ambienLight = 0.25f;
@@ -255,6 +187,7 @@ Render::Render(uint32_t views, RenderDependencies& dependencies)
     UploadMesh(&asteroidMesh, false);
     mAsteroidModel = LoadModelFromMesh(asteroidMesh);
     mAsteroidModel.materials[0].shader = mFowShader;
+    mAsteroidModel.materials[0].maps[MATERIAL_MAP_DIFFUSE].color = GRAY;
 
     for (auto& renderBundle : mRenderTaskBundles) {
         for (size_t i = 0; i < mViews; ++i) {
@@ -305,7 +238,7 @@ Render::~Render()
     UnloadShader(mFowShader);
 }
 
-bool Render::TryStartRenderTasks(const entt::registry& registry)
+bool Render::TryStartRenderTasks(const RenderSnapshot& snapshot)
 {
     ZoneScoped;
     uint32_t bundleIndex;
@@ -328,7 +261,7 @@ bool Render::TryStartRenderTasks(const entt::registry& registry)
 
     for (size_t i = 0; i < mViews; ++i) {
         auto& input = bundle.Inputs[i];
-        input.SimFrame = &registry;
+        input.SimFrame = &snapshot;
         input.Camera = mCameras[i];
         input.Viewport = mViewPorts[i];
         input.CameraRays = ComputeRays(mCameras[i], mViewPorts[i]);
@@ -394,15 +327,15 @@ bool Render::DrawScreenTexture()
         WaitOnProgress(mThreadPool, bundle.Outputs[i].Lists, RenderLists::ProgressRespawners);
         DrawRespawns(bundle.Outputs[i].Lists);
         WaitOnProgress(mThreadPool, bundle.Outputs[i].Lists, RenderLists::ProgressSpaceships);
-        DrawSpaceships(bundle.Outputs[i].Lists);
+        DrawSpaceships(bundle.Outputs[i].Lists, mShipRenderer);
         WaitOnProgress(mThreadPool, bundle.Outputs[i].Lists, RenderLists::ProgressExplosions);
         DrawExplosions(bundle.Outputs[i].Lists);
         WaitOnProgress(mThreadPool, bundle.Outputs[i].Lists, RenderLists::ProgressAsteroids);
         DrawAsteroids(bundle.Outputs[i].Lists, mAsteroidModel, mFowShader, bundle.Outputs[i].Camera);
         WaitOnProgress(mThreadPool, bundle.Outputs[i].Lists, RenderLists::ProgressParticles);
-        DrawParticles(bundle.Outputs[i].Lists);
+        mParticleRenderer.Draw(bundle.Outputs[i].Lists.Particles, bundle.Outputs[i].Camera, mViewPorts[i].height);
         WaitOnProgress(mThreadPool, bundle.Outputs[i].Lists, RenderLists::ProgressBullets);
-        DrawBullets(bundle.Outputs[i].Camera, mGlowTexture, bundle.Outputs[i].Lists);
+        DrawBullets(bundle.Outputs[i].Camera, mGlowTexture, bundle.Outputs[i].Lists, mBillboardRenderer);
 
         EndMode3D();
 
@@ -1,11 +1,14 @@
 #pragma once
 
 #include "DependencyContainer.h"
+#include "RenderSnapshot.h"
 
 #include "ThreadPool/ThreadPool.h"
-#include "entt/entt.hpp"
+#include <Render/BillboardRenderer.h>
 #include <Render/CameraFrustm.h>
+#include <Render/ParticleRenderer.h>
 #include <Render/RenderLists.h>
+#include <Render/ShipRenderer.h>
 #include <raylib.h>
 #include <stack>
 
@@ -20,7 +23,7 @@ using RenderDependencies = DependencyContainer<RenderFlag>;
 
 struct RenderTaskInput
 {
-    const entt::registry* SimFrame;
+    const RenderSnapshot* SimFrame;
     Camera Camera;
     CameraRays CameraRays;
     CameraFrustum Frustum;
@@ -40,7 +43,7 @@ public:
     ~Render();
     bool DrawScreenTexture();
     const Texture& ScreenTexture() const;
-    bool TryStartRenderTasks(const entt::registry& registry);
+    bool TryStartRenderTasks(const RenderSnapshot& snapshot);
 
 private:
     uint32_t mViews;
@@ -53,6 +56,9 @@ private:
 
     Shader mFowShader;
     Model mAsteroidModel;
+    ParticleRenderer mParticleRenderer;
+    BillboardRenderer mBillboardRenderer;
+    ShipRenderer mShipRenderer;
 
     ThreadPool mThreadPool;
     struct RenderTaskBundle
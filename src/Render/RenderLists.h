@@ -1,12 +1,13 @@
 #pragma once
 
 #include "CameraFrustm.h"
-#include "Components.h"
+#include "Data.h"
 #include "FrustumPlaneData.h"
+#include "RenderSnapshot.h"
 #include <SpaceUtil.h>
 #include <tracy/Tracy.hpp>
+#include <algorithm>
 #include <atomic>
-#include <entt/entt.hpp>
 #include <optional>
 #include <raylib.h>
 #include <raymath.h>
@@ -14,6 +15,33 @@
 
 using CameraRays = std::array<Ray, 4>;
 
+constexpr std::array<Color, 2> PlayerColors = {RED, BLUE};
+
+// Per instance data of the spaceship mesh passes
+struct SpaceshipInstance
+{
+    Vector3 Position;
+    Quaternion Rotation;
+    Color Color;
+};
+static_assert(sizeof(SpaceshipInstance) == 32);
+
+// Laid out as the particle vertex buffer expects it
+struct ParticleVertex
+{
+    Vector3 Position;
+    Color Color;
+};
+static_assert(sizeof(ParticleVertex) == 16);
+
+// Per instance data of the bullet billboard pass
+struct BulletInstance
+{
+    Vector3 Position;
+    Color Color;
+};
+static_assert(sizeof(BulletInstance) == 16);
+
 class RenderLists
 {
 public:
@@ -26,11 +54,12 @@ public:
     static constexpr uint32_t AllProgressFlags = (1 << 6) - 1;
 
     std::vector<std::tuple<Vector3, uint32_t>> Respawners;
-    std::vector<std::tuple<Vector3, Quaternion, uint32_t>> Spaceships;
+    std::vector<SpaceshipInstance> Spaceships;
     std::vector<std::tuple<Vector3, float, float>> Explosions;
-    std::vector<std::tuple<Vector3, Color>> Bullets;
+    std::vector<BulletInstance> Bullets;
     std::vector<std::tuple<Vector3, float>> Asteroids;
-    std::vector<std::tuple<Vector3, Color>> Particles;
+    std::vector<Matrix> AsteroidTransforms; // Asteroids as instance transforms, in the same order
+    std::vector<ParticleVertex> Particles;
 
     std::atomic<uint32_t> BakeProgressFlags = 0;
 
@@ -73,6 +102,54 @@ public:
         }
     }
 
+    // Calls action(index) for the elements of every grid cell overlapping the plane rectangle, grown by margin, on the
+    // torus. offset is added to the stored positions before drawing (BackgroundOffset), each cell is visited once.
+    template <typename TAction>
+    void IterateGridCells(const RenderGrid::CellStarts& starts,
+                          const FrustumPlaneData& planeData,
+                          const Vector3& offset,
+                          float margin,
+                          TAction&& action)
+    {
+        // Rectangle in stored coordinates
+        const float minX = planeData.MinX - offset.x - margin;
+        const float maxX = planeData.MaxX - offset.x + margin;
+        const float minZ = planeData.MinZ - offset.z - margin;
+        const float maxZ = planeData.MaxZ - offset.z + margin;
+
+        // Degenerate or wider than the torus: every cell
+        auto cellSpan = [](float min, float max, float length, float cellSize, int32_t cells, int32_t& first) {
+            if (!(max - min < length)) {
+                first = 0;
+                return cells;
+            }
+            first = static_cast<int32_t>(std::floor(min / cellSize));
+            return std::min(static_cast<int32_t>(std::floor(max / cellSize)) - first + 1, cells);
+        };
+        int32_t firstX;
+        int32_t firstZ;
+        const int32_t spanX =
+        cellSpan(minX, maxX, SpaceData::LengthX, RenderGrid::CellSizeX, RenderGrid::CellsX, firstX);
+        const int32_t spanZ =
+        cellSpan(minZ, maxZ, SpaceData::LengthZ, RenderGrid::CellSizeZ, RenderGrid::CellsZ, firstZ);
+        firstX = RenderGrid::Wrap(firstX, RenderGrid::CellsX);
+
+        // Cells of a row are contiguous, so a row is one range, or two when it wraps around
+        auto visitCells = [&](int32_t rowStart, int32_t fromX, int32_t toX) {
+            for (uint32_t index = starts[rowStart + fromX]; index < starts[rowStart + toX]; ++index) {
+                action(index);
+            }
+        };
+        for (int32_t stepZ = 0; stepZ < spanZ; ++stepZ) {
+            const int32_t rowStart = RenderGrid::Wrap(firstZ + stepZ, RenderGrid::CellsZ) * RenderGrid::CellsX;
+            const int32_t lastX = firstX + spanX;
+            visitCells(rowStart, firstX, std::min(lastX, RenderGrid::CellsX));
+            if (lastX > RenderGrid::CellsX) {
+                visitCells(rowStart, 0, lastX - RenderGrid::CellsX);
+            }
+        }
+    }
+
     void Clear()
     {
         BakeProgressFlags = 0;
@@ -82,6 +159,7 @@ public:
         Explosions.clear();
         Bullets.clear();
         Asteroids.clear();
+        AsteroidTransforms.clear();
         Particles.clear();
     }
 
@@ -106,7 +184,7 @@ public:
         return {minX, maxX, minZ, maxZ};
     }
 
-    void BakeRespawners(const entt::registry* simFrame, const CameraRays& cameraRays, const CameraFrustum& frustum)
+    void BakeRespawners(const RenderSnapshot* simFrame, const CameraRays& cameraRays, const CameraFrustum& frustum)
     {
         ZoneScoped;
         assert(Respawners.empty());
@@ -122,46 +200,38 @@ public:
         const FrustumPlaneData foregroundData = ComputeFrustumPlaneData(cameraRays, 0.f);
         const FrustumPlaneData backgroundData = ComputeFrustumPlaneData(cameraRays, BackgroundOffset.y);
 
-        for (auto respawner : simFrame->view<RespawnComponent, PositionComponent>()) {
-            const auto& respawnComponent = simFrame->get<RespawnComponent>(respawner);
-            if (respawnComponent.TimeLeft > 0.f) {
-                continue;
-            }
-            const auto& position = simFrame->get<PositionComponent>(respawner).Position;
-            insertAction(position, respawnComponent.InputId, foregroundData);
-            insertAction(position + BackgroundOffset, respawnComponent.InputId, backgroundData);
+        for (const RenderSnapshot::Respawner& respawner : simFrame->Respawners) {
+            insertAction(respawner.Position, respawner.InputId, foregroundData);
+            insertAction(respawner.Position + BackgroundOffset, respawner.InputId, backgroundData);
         }
         BakeProgressFlags |= (1 << ProgressRespawners);
     }
 
-    void BakeSpaceships(const entt::registry* simFrame, const CameraRays& cameraRays, const CameraFrustum& frustum)
+    void BakeSpaceships(const RenderSnapshot* simFrame, const CameraRays& cameraRays, const CameraFrustum& frustum)
     {
         ZoneScoped;
         assert(Spaceships.empty());
         assert((BakeProgressFlags & (1 << ProgressSpaceships)) == 0);
 
-        auto insertAction = [&](auto&& position, auto&& orientation, auto&& inputID, auto&& planeData) {
+        auto insertAction = [&](auto&& position, auto&& orientation, auto&& color, auto&& planeData) {
             IterateFrustumVisiblePositions(frustum, planeData, position, SpaceshipData::CollisionRadius,
                                            [&](const Vector3& renderPosition) {
-                                               Spaceships.emplace_back(renderPosition, orientation, inputID);
+                                               Spaceships.push_back({renderPosition, orientation, color});
                                            });
         };
 
         const FrustumPlaneData foregroundData = ComputeFrustumPlaneData(cameraRays, 0.f);
         const FrustumPlaneData backgroundData = ComputeFrustumPlaneData(cameraRays, BackgroundOffset.y);
 
-        for (auto entity : simFrame->view<PositionComponent, OrientationComponent, SpaceshipInputComponent>()) {
-
-            const auto& position = simFrame->get<PositionComponent>(entity).Position;
-            const auto& orientation = simFrame->get<OrientationComponent>(entity).Rotation;
-            const uint32_t inputID = simFrame->get<SpaceshipInputComponent>(entity).InputId;
-            insertAction(position, orientation, inputID, foregroundData);
-            insertAction(position + BackgroundOffset, orientation, inputID, backgroundData);
+        for (const RenderSnapshot::Spaceship& spaceship : simFrame->Spaceships) {
+            const Color color = PlayerColors[spaceship.InputId];
+            insertAction(spaceship.Position, spaceship.Rotation, color, foregroundData);
+            insertAction(spaceship.Position + BackgroundOffset, spaceship.Rotation, color, backgroundData);
         }
         BakeProgressFlags |= (1 << ProgressSpaceships);
     }
 
-    void BakeExplosions(const entt::registry* simFrame, const CameraRays& cameraRays, const CameraFrustum& frustum)
+    void BakeExplosions(const RenderSnapshot* simFrame, const CameraRays& cameraRays, const CameraFrustum& frustum)
     {
         ZoneScoped;
         assert(Explosions.empty());
@@ -176,18 +246,16 @@ public:
         const FrustumPlaneData foregroundData = ComputeFrustumPlaneData(cameraRays, 0.f);
         const FrustumPlaneData backgroundData = ComputeFrustumPlaneData(cameraRays, BackgroundOffset.y);
 
-        for (auto explosion : simFrame->view<ExplosionComponent>()) {
-            const Vector3& position = simFrame->get<PositionComponent>(explosion).Position;
-            const ExplosionComponent& explosionComponent = simFrame->get<ExplosionComponent>(explosion);
-            const float radius = explosionComponent.CurrentRadius;
-            const float relativeRadius = radius / explosionComponent.TerminalRadius;
-            insertAction(position, radius, relativeRadius, foregroundData);
-            insertAction(position + BackgroundOffset, radius, relativeRadius, backgroundData);
+        for (const RenderSnapshot::Explosion& explosion : simFrame->Explosions) {
+            const float radius = explosion.CurrentRadius;
+            const float relativeRadius = radius / explosion.TerminalRadius;
+            insertAction(explosion.Position, radius, relativeRadius, foregroundData);
+            insertAction(explosion.Position + BackgroundOffset, radius, relativeRadius, backgroundData);
         }
         BakeProgressFlags |= (1 << ProgressExplosions);
     }
 
-    void BakeAsteroids(const entt::registry* simFrame, const CameraRays& cameraRays, const CameraFrustum& frustum)
+    void BakeAsteroids(const RenderSnapshot* simFrame, const CameraRays& cameraRays, const CameraFrustum& frustum)
     {
         ZoneScoped;
         assert((BakeProgressFlags & (1 << ProgressAsteroids)) == 0);
@@ -201,16 +269,27 @@ public:
         const FrustumPlaneData foregroundData = ComputeFrustumPlaneData(cameraRays, 0.f);
         const FrustumPlaneData backgroundData = ComputeFrustumPlaneData(cameraRays, BackgroundOffset.y);
 
-        for (auto asteroid : simFrame->view<AsteroidComponent>()) {
-            const float radius = simFrame->get<AsteroidComponent>(asteroid).Radius;
-            const Vector3 position = simFrame->get<PositionComponent>(asteroid).Position;
-            insertAction(position, radius, foregroundData);
-            insertAction(position + BackgroundOffset, radius, backgroundData);
+        const std::vector<RenderSnapshot::Asteroid>& asteroids = simFrame->Asteroids;
+        IterateGridCells(simFrame->AsteroidCellStarts, foregroundData, Vector3Zero(), SpaceData::MaxAsteroidRadius,
+                         [&](uint32_t index) {
+                             insertAction(asteroids[index].Position, asteroids[index].Radius, foregroundData);
+                         });
+        IterateGridCells(simFrame->AsteroidCellStarts, backgroundData, BackgroundOffset, SpaceData::MaxAsteroidRadius,
+                         [&](uint32_t index) {
+                             insertAction(asteroids[index].Position + BackgroundOffset, asteroids[index].Radius,
+                                          backgroundData);
+                         });
+
+        // Scale then translate, built here so the render thread only uploads them
+        AsteroidTransforms.reserve(Asteroids.size());
+        for (const auto& [position, radius] : Asteroids) {
+            AsteroidTransforms.push_back({radius, 0.f, 0.f, position.x, 0.f, radius, 0.f, position.y, 0.f, 0.f, radius,
+                                          position.z, 0.f, 0.f, 0.f, 1.f});
         }
         BakeProgressFlags |= (1 << ProgressAsteroids);
     }
 
-    void BakeBullets(const entt::registry* simFrame, const CameraRays& cameraRays, const CameraFrustum& frustum)
+    void BakeBullets(const RenderSnapshot* simFrame, const CameraRays& cameraRays, const CameraFrustum& frustum)
     {
         ZoneScoped;
         assert(Bullets.empty());
@@ -218,23 +297,21 @@ public:
 
         auto insertAction = [&](auto&& position, auto&& color, auto&& planeData) {
             IterateFrustumVisiblePositions(frustum, planeData, position, 0.f, [&](const Vector3& renderPosition) {
-                Bullets.emplace_back(renderPosition, color);
+                Bullets.push_back({renderPosition, color});
             });
         };
 
         const FrustumPlaneData foregroundData = ComputeFrustumPlaneData(cameraRays, 0.f);
         const FrustumPlaneData backgroundData = ComputeFrustumPlaneData(cameraRays, BackgroundOffset.y);
 
-        for (entt::entity particle : simFrame->view<BulletComponent>()) {
-            const Vector3 position = simFrame->get<PositionComponent>(particle).Position;
-            const Color color = simFrame->get<ParticleComponent>(particle).Color;
-            insertAction(position, color, foregroundData);
-            insertAction(position + BackgroundOffset, color, backgroundData);
+        for (const RenderSnapshot::Bullet& bullet : simFrame->Bullets) {
+            insertAction(bullet.Position, bullet.Color, foregroundData);
+            insertAction(bullet.Position + BackgroundOffset, bullet.Color, backgroundData);
         }
         BakeProgressFlags |= (1 << ProgressBullets);
     }
 
-    void BakeParticles(const entt::registry* simFrame, const CameraRays& cameraRays, const CameraFrustum& frustum)
+    void BakeParticles(const RenderSnapshot* simFrame, const CameraRays& cameraRays, const CameraFrustum& frustum)
     {
         ZoneScoped;
         assert(Particles.empty());
@@ -242,19 +319,20 @@ public:
 
         auto insertAction = [&](auto&& position, auto&& color, auto&& planeData) {
             IterateFrustumVisiblePositions(frustum, planeData, position, 0.f, [&](const Vector3& renderPosition) {
-                Particles.emplace_back(renderPosition, color);
+                Particles.push_back({renderPosition, color});
             });
         };
 
         const FrustumPlaneData foregroundData = ComputeFrustumPlaneData(cameraRays, 0.f);
         const FrustumPlaneData backgroundData = ComputeFrustumPlaneData(cameraRays, BackgroundOffset.y);
 
-        for (entt::entity particle : simFrame->view<ParticleComponent>(entt::exclude<BulletComponent>)) {
-            const Vector3 position = simFrame->get<PositionComponent>(particle).Position;
-            const Color color = simFrame->get<ParticleComponent>(particle).Color;
-            insertAction(position, color, foregroundData);
-            insertAction(position + BackgroundOffset, color, backgroundData);
-        }
+        IterateGridCells(simFrame->ParticleCellStarts, foregroundData, Vector3Zero(), 0.f, [&](uint32_t index) {
+            insertAction(simFrame->GetParticlePosition(index), simFrame->ParticleColors[index], foregroundData);
+        });
+        IterateGridCells(simFrame->ParticleCellStarts, backgroundData, BackgroundOffset, 0.f, [&](uint32_t index) {
+            insertAction(simFrame->GetParticlePosition(index) + BackgroundOffset, simFrame->ParticleColors[index],
+                         backgroundData);
+        });
         BakeProgressFlags |= (1 << ProgressParticles);
     }
 };
\ No newline at end of file
@@ -0,0 +1,109 @@
+#include "ShipRenderer.h"
+#include "VertexAttribute.h"
+
+#include <array>
+#include <cstddef>
+#include <external/glad.h>
+#include <raymath.h>
+#include <rlgl.h>
+#include <tracy/Tracy.hpp>
+
+namespace {
+constexpr size_t MinCapacity = 16;
+
+constexpr float Scale = 0.65f;
+constexpr std::array<Vector3, 7> HullVertices = {
+Vector3{0.f, 0.f, 2.f * Scale},               // 0 : nose
+Vector3{-1.25f * Scale, 0.f, -Scale},         // 1 : wingL
+Vector3{1.25f * Scale, 0.f, -Scale},          // 2 : wingR
+Vector3{0.f, 0.f, 0.f},                       // 3 : center
+Vector3{0.f, 0.f, -Scale},                    // 4 : tail
+Vector3{0.f, Scale * 1.5f, -1.5f * Scale},    // 5 : finT
+Vector3{0.f, -0.75f * Scale, -0.75f * Scale}, // 6 : finB
+};
+
+constexpr std::array<std::array<int, 3>, 3> HullTriangles = {std::array<int, 3>{0, 1, 2}, std::array<int, 3>{3, 4, 5},
+                                                             std::array<int, 3>{0, 4, 6}};
+
+constexpr size_t FillVertexCount = HullTriangles.size() * 6; // Both windings, so culling keeps either side
+constexpr size_t WireVertexCount = HullTriangles.size() * 6; // Three edges per triangle
+
+// Fill triangles first, then wire lines
+std::array<Vector3, FillVertexCount + WireVertexCount> MakeHullMesh()
+{
+    std::array<Vector3, FillVertexCount + WireVertexCount> mesh;
+    size_t index = 0;
+    for (const auto& triangle : HullTriangles) {
+        for (int corner : {0, 1, 2, 2, 1, 0}) {
+            mesh[index++] = HullVertices[triangle[corner]];
+        }
+    }
+    for (const auto& triangle : HullTriangles) {
+        for (int corner : {0, 1, 1, 2, 2, 0}) {
+            mesh[index++] = HullVertices[triangle[corner]];
+        }
+    }
+    return mesh;
+}
+} // namespace
+
+ShipRenderer::ShipRenderer() : mInstanceBuffer(MinCapacity * sizeof(SpaceshipInstance))
+{
+    mShader = LoadShader("resources/ship.vs", "resources/ship.fs");
+    mFillColorLoc = GetShaderLocation(mShader, "fillColor");
+    mWireLoc = GetShaderLocation(mShader, "wire");
+
+    glGenVertexArrays(1, &mVertexArray);
+    glGenBuffers(1, &mMeshBuffer);
+    glBindVertexArray(mVertexArray);
+
+    const std::array<Vector3, FillVertexCount + WireVertexCount> mesh = MakeHullMesh();
+    glBindBuffer(GL_ARRAY_BUFFER, mMeshBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(mesh), mesh.data(), GL_STATIC_DRAW);
+    EnableVertexAttribute(mShader.locs[SHADER_LOC_VERTEX_POSITION], 3, GL_FLOAT, false, sizeof(Vector3), 0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, mInstanceBuffer.Id());
+    EnableVertexAttribute(GetShaderLocationAttrib(mShader, "instancePosition"), 3, GL_FLOAT, false,
+                          sizeof(SpaceshipInstance), offsetof(SpaceshipInstance, Position), 1);
+    EnableVertexAttribute(GetShaderLocationAttrib(mShader, "instanceRotation"), 4, GL_FLOAT, false,
+                          sizeof(SpaceshipInstance), offsetof(SpaceshipInstance, Rotation), 1);
+    EnableVertexAttribute(GetShaderLocationAttrib(mShader, "instanceColor"), 4, GL_UNSIGNED_BYTE, true,
+                          sizeof(SpaceshipInstance), offsetof(SpaceshipInstance, Color), 1);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+ShipRenderer::~ShipRenderer()
+{
+    glDeleteBuffers(1, &mMeshBuffer);
+    glDeleteVertexArrays(1, &mVertexArray);
+    UnloadShader(mShader);
+}
+
+void ShipRenderer::Draw(const std::vector<SpaceshipInstance>& instances, Color fillColor)
+{
+    ZoneScoped;
+    // The default shader LoadShader falls back to has no instance attributes
+    if (instances.empty() || mShader.id == rlGetShaderIdDefault()) {
+        return;
+    }
+    mInstanceBuffer.Upload(instances);
+
+    const Matrix mvp = MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection());
+    const Vector4 fill = ColorNormalize(fillColor);
+    rlEnableShader(mShader.id);
+    rlSetUniformMatrix(mShader.locs[SHADER_LOC_MATRIX_MVP], mvp);
+    rlSetUniform(mFillColorLoc, &fill, RL_SHADER_UNIFORM_VEC4, 1);
+
+    const GLsizei count = static_cast<GLsizei>(instances.size());
+    glBindVertexArray(mVertexArray);
+    int wire = 0;
+    rlSetUniform(mWireLoc, &wire, RL_SHADER_UNIFORM_INT, 1);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, FillVertexCount, count);
+    wire = 1;
+    rlSetUniform(mWireLoc, &wire, RL_SHADER_UNIFORM_INT, 1);
+    glDrawArraysInstanced(GL_LINES, FillVertexCount, WireVertexCount, count);
+    glBindVertexArray(0);
+    rlDisableShader();
+}
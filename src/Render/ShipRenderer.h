@@ -0,0 +1,29 @@
+#pragma once
+
+#include "RenderLists.h"
+#include "StreamedBuffer.h"
+#include <raylib.h>
+#include <stdint.h>
+#include <vector>
+
+// Spaceship hull kept on the GPU: a fill pass in a shared color and a wire pass in each instance's color, one
+// instanced call each. The vertex shader rotates the hull by the instance quaternion and moves it to its position.
+class ShipRenderer final
+{
+public:
+    ShipRenderer();
+    ~ShipRenderer();
+    ShipRenderer(const ShipRenderer&) = delete;
+    ShipRenderer& operator=(const ShipRenderer&) = delete;
+
+    // Between BeginMode3D and EndMode3D
+    void Draw(const std::vector<SpaceshipInstance>& instances, Color fillColor);
+
+private:
+    Shader mShader;
+    int mFillColorLoc;
+    int mWireLoc;
+    uint32_t mVertexArray = 0;
+    uint32_t mMeshBuffer = 0;
+    StreamedBuffer mInstanceBuffer;
+};
@@ -0,0 +1,33 @@
+#include "StreamedBuffer.h"
+
+#include <algorithm>
+#include <external/glad.h>
+#include <rlgl.h>
+
+StreamedBuffer::StreamedBuffer(size_t minCapacity) : mMinCapacity(minCapacity)
+{
+    glGenBuffers(1, &mBuffer);
+}
+
+StreamedBuffer::~StreamedBuffer()
+{
+    glDeleteBuffers(1, &mBuffer);
+}
+
+uint32_t StreamedBuffer::Id() const
+{
+    return mBuffer;
+}
+
+void StreamedBuffer::upload(const void* data, size_t size)
+{
+    rlDrawRenderBatchActive();
+
+    glBindBuffer(GL_ARRAY_BUFFER, mBuffer);
+    if (size > mCapacity) {
+        mCapacity = std::max({size, 2 * mCapacity, mMinCapacity});
+    }
+    glBufferData(GL_ARRAY_BUFFER, mCapacity, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, size, data);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
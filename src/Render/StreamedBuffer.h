@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// Vertex buffer refilled every draw. Each upload orphans the storage before filling it, so the driver hands out a
+// fresh buffer instead of stalling on draws still reading the previous contents. Capacity only grows.
+class StreamedBuffer final
+{
+public:
+    explicit StreamedBuffer(size_t minCapacity); // In bytes
+    ~StreamedBuffer();
+    StreamedBuffer(const StreamedBuffer&) = delete;
+    StreamedBuffer& operator=(const StreamedBuffer&) = delete;
+
+    uint32_t Id() const;
+
+    // Flushes raylib's pending batch first, whatever was drawn in immediate mode so far stays ahead of the caller's
+    // draw. Leaves no buffer bound.
+    template <typename T>
+    void Upload(const std::vector<T>& items)
+    {
+        upload(items.data(), items.size() * sizeof(T));
+    }
+
+private:
+    void upload(const void* data, size_t size);
+
+    uint32_t mBuffer = 0;
+    size_t mCapacity = 0;
+    size_t mMinCapacity;
+};
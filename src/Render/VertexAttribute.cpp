@@ -0,0 +1,24 @@
+#include "VertexAttribute.h"
+
+#include <external/glad.h>
+
+bool EnableVertexAttribute(int location,
+                           int components,
+                           uint32_t type,
+                           bool normalized,
+                           size_t stride,
+                           size_t offset,
+                           uint32_t divisor)
+{
+    if (location < 0) {
+        return false;
+    }
+    const GLuint index = static_cast<GLuint>(location);
+    glEnableVertexAttribArray(index);
+    glVertexAttribPointer(index, components, type, normalized ? GL_TRUE : GL_FALSE, static_cast<GLsizei>(stride),
+                          reinterpret_cast<const void*>(offset));
+    if (divisor != 0) {
+        glVertexAttribDivisor(index, divisor);
+    }
+    return true;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Points an attribute at the bound GL_ARRAY_BUFFER, advancing per instance when divisor isn't zero. Locations are
+// -1 when the attribute was optimized out or the shader failed to load, those are skipped and false is returned.
+bool EnableVertexAttribute(int location,
+                           int components,
+                           uint32_t type,
+                           bool normalized,
+                           size_t stride,
+                           size_t offset,
+                           uint32_t divisor = 0);
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "Data.h"
+#include <array>
+#include <cmath>
+#include <raylib.h>
+#include <stdint.h>
+#include <vector>
+
+// Uniform grid over the torus, with the simulation partition's cells. Populous arrays of the snapshot are stored in
+// cell order, elements of cell c at [CellStarts[c], CellStarts[c + 1]), so bakes only visit the cells a view overlaps.
+namespace RenderGrid {
+constexpr int32_t CellsX = SpaceData::CellCountX;
+constexpr int32_t CellsZ = SpaceData::CellCountZ;
+constexpr size_t CellCount = CellsX * CellsZ;
+constexpr float CellSizeX = SpaceData::LengthX / CellsX;
+constexpr float CellSizeZ = SpaceData::LengthZ / CellsZ;
+
+using CellStarts = std::array<uint32_t, CellCount + 1>;
+
+inline int32_t Wrap(int32_t cell, int32_t cells)
+{
+    const int32_t wrapped = cell % cells;
+    return wrapped < 0 ? wrapped + cells : wrapped;
+}
+
+// Positions a little outside the torus land in the cell of their wrapped copy
+inline uint32_t CellOf(float x, float z)
+{
+    const int32_t cellX = Wrap(static_cast<int32_t>(std::floor(x / CellSizeX)), CellsX);
+    const int32_t cellZ = Wrap(static_cast<int32_t>(std::floor(z / CellSizeZ)), CellsZ);
+    return static_cast<uint32_t>(cellZ * CellsX + cellX);
+}
+
+// Counting sort of count elements: cellOf(index) gives an element's cell, place(index, slot) moves it to its slot
+template <typename TCellOf, typename TPlace>
+void SortIntoCells(size_t count, CellStarts& starts, TCellOf&& cellOf, TPlace&& place)
+{
+    starts.fill(0);
+    for (size_t index = 0; index < count; ++index) {
+        starts[cellOf(index) + 1] += 1;
+    }
+    for (size_t cell = 1; cell < starts.size(); ++cell) {
+        starts[cell] += starts[cell - 1];
+    }
+    CellStarts cursors = starts;
+    for (size_t index = 0; index < count; ++index) {
+        place(index, cursors[cellOf(index)]++);
+    }
+}
+} // namespace RenderGrid
+
+// Flat copy of what the render bakes need from one simulation frame.
+// Arrays are cleared and refilled every frame so their capacity is reused across handoffs.
+struct RenderSnapshot
+{
+    struct Respawner
+    {
+        Vector3 Position;
+        uint32_t InputId;
+    };
+
+    struct Spaceship
+    {
+        Vector3 Position;
+        Quaternion Rotation;
+        uint32_t InputId;
+    };
+
+    struct Explosion
+    {
+        Vector3 Position;
+        float CurrentRadius;
+        float TerminalRadius;
+    };
+
+    struct Asteroid
+    {
+        Vector3 Position;
+        float Radius;
+    };
+
+    struct Bullet
+    {
+        Vector3 Position;
+        Color Color;
+    };
+
+    uint32_t Frame = 0;
+    double PublishTime = 0.0; // Stamped by the sim thread on handoff, for latency tracking
+    std::vector<Respawner> Respawners; // Only the ones already placeable, still counting down ones are not drawn
+    std::vector<Spaceship> Spaceships;
+    std::vector<Explosion> Explosions;
+    std::vector<Asteroid> Asteroids; // In RenderGrid cell order
+    RenderGrid::CellStarts AsteroidCellStarts = {};
+    std::vector<Bullet> Bullets;
+    std::vector<float> ParticlesX;
+    std::vector<float> ParticlesY;
+    std::vector<float> ParticlesZ;
+    std::vector<Color> ParticleColors;
+    RenderGrid::CellStarts ParticleCellStarts = {}; // Particle arrays are in RenderGrid cell order
+
+    size_t ParticleCount() const
+    {
+        return ParticleColors.size();
+    }
+
+    Vector3 GetParticlePosition(size_t index) const
+    {
+        return {ParticlesX[index], ParticlesY[index], ParticlesZ[index]};
+    }
+
+    void Clear()
+    {
+        Frame = 0;
+        Respawners.clear();
+        Spaceships.clear();
+        Explosions.clear();
+        Asteroids.clear();
+        Bullets.clear();
+        ParticlesX.clear();
+        ParticlesY.clear();
+        ParticlesZ.clear();
+        ParticleColors.clear();
+        AsteroidCellStarts.fill(0);
+        ParticleCellStarts.fill(0);
+    }
+};
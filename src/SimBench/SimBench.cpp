@@ -0,0 +1,499 @@
+#include "Components.h"
+#include "Data.h"
+#include "DependencyContainer.h"
+#include "Simulation/ParticleKernels.h"
+#include "Simulation/Replay.h"
+#include "Simulation/Rollback.h"
+#include "Simulation/SimSnapshot.h"
+#include "Simulation/SimTimings.h"
+#include "Simulation/Simulation.h"
+#include "entt/entt.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+
+namespace {
+struct BenchSettings
+{
+    uint32_t Ticks = 3600;
+    uint32_t Asteroids = SpaceData::AsteroidsCount;
+    uint32_t Players = 2;
+    uint32_t ReportInterval = 600;
+    uint32_t FirePeriod = 30; // Fire held for this many ticks, then released for as many
+    float Thrust = 1.f;
+    float Turn = 0.35f; // Steering oscillation frequency, in radians per second
+    SimSettings Sim;
+    const char* RecordPath = nullptr;
+    const char* ReplayPath = nullptr; // Input, seed and player count come from the log instead
+    bool Verify = false;
+    const char* LoadPath = nullptr; // Snapshot the run starts from instead of a fresh field
+    const char* SavePath = nullptr;
+    bool Rollback = false;
+    uint32_t Latency = 0; // Loopback delay of the rollback mode, in steps
+};
+
+void PrintUsage()
+{
+    std::printf("SimBench [options]\n"
+                "  --ticks N        Ticks to simulate\n"
+                "  --asteroids N    Asteroids spawned on init\n"
+                "  --players N      Spaceships spawned on init (at most 2)\n"
+                "  --report N       Print entity counts every N ticks (0 to disable)\n"
+                "  --fire-period N  Ticks the fire input is held and then released (0 never fires)\n"
+                "  --thrust X       Forward input in [0, 1]\n"
+                "  --turn X         Steering oscillation frequency\n"
+                "  --broadphase M   Asteroid pair iteration: sorted (default), corner or parallel\n"
+                "  --partition M    Spatial partition update: rebuild (default) or incremental\n"
+                "  --systems M      System scheduling: graph (default) or serial\n"
+                "  --seed N         Seed of the simulation random streams\n"
+                "  --record PATH    Write the input log and state hashes of the run\n"
+                "  --replay PATH    Re-simulate a recorded log and verify its state hashes\n"
+                "  --verify 0|1     Compare state hashes every tick against a serial reference simulation\n"
+                "  --load PATH      Start from a saved snapshot instead of a fresh asteroid field\n"
+                "  --save PATH      Save a snapshot of the final state\n"
+                "  --rollback N     Run two rollback peers over a loopback link delaying input by N steps\n");
+}
+
+bool ParseSettings(int argc, char** argv, BenchSettings& settings)
+{
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (std::strcmp(arg, "--help") == 0) {
+            return false;
+        }
+        if (i + 1 >= argc) {
+            std::printf("Missing value for %s\n", arg);
+            return false;
+        }
+        const char* value = argv[++i];
+        if (std::strcmp(arg, "--ticks") == 0) {
+            settings.Ticks = std::strtoul(value, nullptr, 10);
+        } else if (std::strcmp(arg, "--asteroids") == 0) {
+            settings.Asteroids = std::strtoul(value, nullptr, 10);
+        } else if (std::strcmp(arg, "--players") == 0) {
+            settings.Players = std::min<uint32_t>(std::strtoul(value, nullptr, 10), 2);
+        } else if (std::strcmp(arg, "--report") == 0) {
+            settings.ReportInterval = std::strtoul(value, nullptr, 10);
+        } else if (std::strcmp(arg, "--fire-period") == 0) {
+            settings.FirePeriod = std::strtoul(value, nullptr, 10);
+        } else if (std::strcmp(arg, "--thrust") == 0) {
+            settings.Thrust = std::clamp(std::strtof(value, nullptr), 0.f, 1.f);
+        } else if (std::strcmp(arg, "--turn") == 0) {
+            settings.Turn = std::strtof(value, nullptr);
+        } else if (std::strcmp(arg, "--record") == 0) {
+            settings.RecordPath = value;
+        } else if (std::strcmp(arg, "--replay") == 0) {
+            settings.ReplayPath = value;
+        } else if (std::strcmp(arg, "--load") == 0) {
+            settings.LoadPath = value;
+        } else if (std::strcmp(arg, "--save") == 0) {
+            settings.SavePath = value;
+        } else if (std::strcmp(arg, "--rollback") == 0) {
+            settings.Rollback = true;
+            settings.Latency = std::strtoul(value, nullptr, 10);
+        } else if (std::strcmp(arg, "--verify") == 0) {
+            settings.Verify = std::strtoul(value, nullptr, 10) != 0;
+        } else if (std::strcmp(arg, "--seed") == 0) {
+            settings.Sim.Seed = std::strtoull(value, nullptr, 10);
+        } else if (std::strcmp(arg, "--broadphase") == 0) {
+            if (std::strcmp(value, "sorted") == 0) {
+                settings.Sim.Broadphase = BroadphaseMode::SortedDedup;
+            } else if (std::strcmp(value, "corner") == 0) {
+                settings.Sim.Broadphase = BroadphaseMode::MinCorner;
+            } else if (std::strcmp(value, "parallel") == 0) {
+                settings.Sim.Broadphase = BroadphaseMode::ParallelMinCorner;
+            } else {
+                std::printf("Unknown broadphase %s\n", value);
+                return false;
+            }
+        } else if (std::strcmp(arg, "--partition") == 0) {
+            if (std::strcmp(value, "rebuild") == 0) {
+                settings.Sim.IncrementalPartition = false;
+            } else if (std::strcmp(value, "incremental") == 0) {
+                settings.Sim.IncrementalPartition = true;
+            } else {
+                std::printf("Unknown partition mode %s\n", value);
+                return false;
+            }
+        } else if (std::strcmp(arg, "--systems") == 0) {
+            if (std::strcmp(value, "graph") == 0) {
+                settings.Sim.ParallelSystems = true;
+            } else if (std::strcmp(value, "serial") == 0) {
+                settings.Sim.ParallelSystems = false;
+            } else {
+                std::printf("Unknown systems mode %s\n", value);
+                return false;
+            }
+        } else {
+            std::printf("Unknown option %s\n", arg);
+            return false;
+        }
+    }
+    // Logs only know how to start from Init
+    if (settings.LoadPath != nullptr && (settings.RecordPath != nullptr || settings.ReplayPath != nullptr)) {
+        std::printf("--load can't be combined with --record or --replay\n");
+        return false;
+    }
+    if (settings.Rollback && (settings.RecordPath != nullptr || settings.ReplayPath != nullptr)) {
+        std::printf("--rollback can't be combined with --record or --replay\n");
+        return false;
+    }
+    // Restored runs rebuild the partition slots in a different order, so they wouldn't match the reference
+    if (settings.Rollback && settings.Sim.IncrementalPartition) {
+        std::printf("--rollback can't be combined with --partition incremental\n");
+        return false;
+    }
+    return true;
+}
+
+// Deterministic stand-in for UpdateInput: ships circle around while pulsing the trigger
+void ScriptInput(const BenchSettings& settings, uint32_t tick, std::array<GameInput, 2>& gameInput)
+{
+    for (uint32_t idx = 0; idx < gameInput.size(); ++idx) {
+        const float angle = settings.Turn * SimTimeData::DeltaTime * tick + idx * PI;
+        GameInput& input = gameInput[idx];
+        input.Forward = settings.Thrust * std::cos(angle);
+        input.Left = settings.Thrust * std::sin(angle);
+        input.SecondaryForward = 0.f;
+        input.SecondaryLeft = 0.f;
+        input.Fire = settings.FirePeriod > 0 && ((tick / settings.FirePeriod) % 2) == 0;
+    }
+}
+
+struct EntityCounts
+{
+    size_t Alive;
+    size_t Asteroids;
+    size_t Spaceships;
+    size_t Bullets;
+    size_t Particles;
+};
+
+EntityCounts CountEntities(const entt::registry& registry, const Simulation& sim)
+{
+    EntityCounts counts;
+    counts.Alive = registry.alive();
+    counts.Asteroids = registry.view<AsteroidComponent>().size();
+    counts.Spaceships = registry.view<SpaceshipInputComponent>().size();
+    counts.Bullets = registry.view<BulletComponent>().size();
+    counts.Particles = sim.GetParticles().Size();
+    return counts;
+}
+
+void PrintCounts(const char* label, const EntityCounts& counts)
+{
+    std::printf("%-8s entities %8zu | asteroids %7zu | spaceships %2zu | bullets %6zu | particles %8zu\n", label,
+                counts.Alive, counts.Asteroids, counts.Spaceships, counts.Bullets, counts.Particles);
+}
+
+// Stand-in for the network between two rollback peers: inputs come out in order, a fixed number of steps after
+// they were sent
+class LoopbackChannel final
+{
+public:
+    explicit LoopbackChannel(uint32_t latency) : mLatency(latency)
+    {}
+
+    void Send(uint32_t step, uint32_t tick, const GameInput& input)
+    {
+        mMessages.push_back({step + mLatency, tick, input});
+    }
+
+    // Everything due by step, or everything in flight when flushing
+    bool Deliver(uint32_t step, RollbackSession& session, bool flush = false)
+    {
+        while (!mMessages.empty() && (flush || mMessages.front().DueStep <= step)) {
+            if (!session.AddRemoteInput(mMessages.front().Tick, mMessages.front().Input)) {
+                return false;
+            }
+            mMessages.pop_front();
+        }
+        return true;
+    }
+
+private:
+    struct Message
+    {
+        uint32_t DueStep;
+        uint32_t Tick;
+        GameInput Input;
+    };
+
+    uint32_t mLatency;
+    std::deque<Message> mMessages;
+};
+
+struct RollbackPeer
+{
+    SimDependencies Dependencies;
+    std::shared_ptr<std::array<GameInput, 2>> Input = std::make_shared<std::array<GameInput, 2>>();
+    std::unique_ptr<Simulation> Sim;
+    std::unique_ptr<RollbackSession> Session;
+    LoopbackChannel Inbox;
+    SimTimings::Clock::duration StepMax = SimTimings::Clock::duration::zero();
+
+    explicit RollbackPeer(uint32_t latency) : Inbox(latency)
+    {}
+
+    // False when the starting snapshot can't be loaded
+    bool Init(const BenchSettings& settings, const std::vector<uint8_t>& snapshot, uint32_t localPlayer)
+    {
+        Dependencies.CreateDependency<entt::registry>();
+        Dependencies.AddDependency(Input);
+        Sim = std::make_unique<Simulation>(Dependencies);
+        Sim->Settings = settings.Sim;
+        Sim->Init(settings.Players, settings.Asteroids);
+        if (!snapshot.empty() && !Sim->LoadSnapshot(snapshot.data(), snapshot.size())) {
+            return false;
+        }
+        Session = std::make_unique<RollbackSession>(*Sim, *Input, localPlayer);
+        Session->Start();
+        return true;
+    }
+};
+
+// Two peers each own one player and see the other's input late. Once all input is delivered both must match a
+// simulation that knew the input all along.
+int RunRollback(const BenchSettings& settings,
+                Simulation& reference,
+                std::array<GameInput, 2>& referenceInput,
+                const std::vector<uint8_t>& snapshot)
+{
+    std::printf("Rollback: %u ticks, %u asteroids, latency %u steps, window %u ticks\n", settings.Ticks,
+                settings.Asteroids, settings.Latency, RollbackWindow);
+    std::array<std::unique_ptr<RollbackPeer>, 2> peers = {std::make_unique<RollbackPeer>(settings.Latency),
+                                                          std::make_unique<RollbackPeer>(settings.Latency)};
+    for (uint32_t player = 0; player < peers.size(); ++player) {
+        if (!peers[player]->Init(settings, snapshot, player)) {
+            std::printf("Peer %u cannot load the starting snapshot\n", player);
+            return 1;
+        }
+    }
+    const uint32_t startTick = peers[0]->Session->CurrentTick();
+    const uint32_t endTick = startTick + settings.Ticks;
+
+    using Clock = SimTimings::Clock;
+    std::array<GameInput, 2> script;
+    uint32_t step = 0;
+    while (peers[0]->Session->CurrentTick() < endTick || peers[1]->Session->CurrentTick() < endTick) {
+        for (uint32_t player = 0; player < peers.size(); ++player) {
+            RollbackPeer& peer = *peers[player];
+            RollbackPeer& remote = *peers[1 - player];
+            if (!peer.Inbox.Deliver(step, *peer.Session)) {
+                std::printf("Input out of order at step %u\n", step);
+                return 1;
+            }
+            const uint32_t tick = peer.Session->CurrentTick();
+            if (tick == endTick) {
+                continue;
+            }
+            ScriptInput(settings, tick - startTick, script);
+            const Clock::time_point start = Clock::now();
+            if (peer.Session->Advance(script[player])) {
+                remote.Inbox.Send(step, tick, script[player]);
+            } else if (peer.Session->Failed()) {
+                std::printf("Peer %u failed to restore a snapshot at step %u\n", player, step);
+                return 1;
+            }
+            peer.StepMax = std::max(peer.StepMax, Clock::now() - start);
+        }
+        step += 1;
+    }
+    for (uint32_t player = 0; player < peers.size(); ++player) {
+        peers[player]->Inbox.Deliver(step, *peers[player]->Session, true);
+        if (!peers[player]->Session->Resimulate()) {
+            std::printf("Peer %u failed to restore a snapshot\n", player);
+            return 1;
+        }
+    }
+
+    for (uint32_t tick = 0; tick < settings.Ticks; ++tick) {
+        ScriptInput(settings, tick, referenceInput);
+        reference.Tick();
+    }
+
+    using Millis = std::chrono::duration<double, std::milli>;
+    bool matched = true;
+    for (uint32_t player = 0; player < peers.size(); ++player) {
+        const RollbackPeer& peer = *peers[player];
+        const RollbackStats& stats = peer.Session->Stats();
+        const bool peerMatched = peer.Sim->StateHash() == reference.StateHash();
+        matched = matched && peerMatched;
+        std::printf("Peer %u %s: %u rollbacks, %u resimulated ticks, max depth %u, %u stalls, max step %.3f ms\n",
+                    player, peerMatched ? "matched" : "DIVERGED", stats.Rollbacks, stats.ResimulatedTicks,
+                    stats.MaxDepth, stats.Stalls, Millis(peer.StepMax).count());
+    }
+    std::printf("%u steps, realtime budget %.3f ms\n", step, 1000.0 * SimTimeData::DeltaTime);
+    return matched ? 0 : 1;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    BenchSettings settings;
+    if (!ParseSettings(argc, argv, settings)) {
+        PrintUsage();
+        return 1;
+    }
+
+    SimDependencies simDependencies;
+    entt::registry& simRegistry = simDependencies.CreateDependency<entt::registry>();
+    auto gameInput = std::make_shared<std::array<GameInput, 2>>();
+    simDependencies.AddDependency(gameInput);
+
+    ReplayReader replay;
+    if (settings.ReplayPath != nullptr) {
+        if (!replay.Open(settings.ReplayPath)) {
+            std::printf("Cannot read replay %s\n", settings.ReplayPath);
+            return 1;
+        }
+        replay.Header().ApplyTo(settings.Sim);
+        settings.Players = replay.Header().Players;
+        settings.Asteroids = replay.Header().Asteroids;
+    }
+    ReplayRecorder recorder;
+    if (settings.RecordPath != nullptr &&
+        !recorder.Open(settings.RecordPath,
+                       ReplayHeader::FromSettings(settings.Sim, settings.Players, settings.Asteroids))) {
+        std::printf("Cannot write replay %s\n", settings.RecordPath);
+        return 1;
+    }
+    const bool replaying = settings.ReplayPath != nullptr;
+
+    std::unique_ptr<Simulation> sim = std::make_unique<Simulation>(simDependencies);
+    sim->Settings = settings.Sim;
+    sim->Init(settings.Players, settings.Asteroids);
+    std::vector<uint8_t> snapshot;
+    if (settings.LoadPath != nullptr) {
+        if (!ReadSnapshotFile(settings.LoadPath, snapshot) || !sim->LoadSnapshot(snapshot.data(), snapshot.size())) {
+            std::printf("Cannot load snapshot %s\n", settings.LoadPath);
+            return 1;
+        }
+        std::printf("Loaded snapshot %s\n", settings.LoadPath);
+    }
+    if (settings.Rollback) {
+        return RunRollback(settings, *sim, *gameInput, snapshot);
+    }
+
+    SimTimings timings;
+    sim->SetTimings(&timings);
+
+    // Same input, systems run one after the other on this thread
+    SimDependencies referenceDependencies;
+    referenceDependencies.CreateDependency<entt::registry>();
+    referenceDependencies.AddDependency(gameInput);
+    std::unique_ptr<Simulation> reference;
+    if (settings.Verify) {
+        reference = std::make_unique<Simulation>(referenceDependencies);
+        reference->Settings = settings.Sim;
+        reference->Settings.ParallelSystems = false;
+        reference->Init(settings.Players, settings.Asteroids);
+        if (settings.LoadPath != nullptr && !reference->LoadSnapshot(snapshot.data(), snapshot.size())) {
+            std::printf("Reference cannot load snapshot %s\n", settings.LoadPath);
+            return 1;
+        }
+    }
+
+    if (replaying) {
+        std::printf("Replaying %s: %u asteroids, %u players, seed %llu\n", settings.ReplayPath, settings.Asteroids,
+                    settings.Players, static_cast<unsigned long long>(settings.Sim.Seed));
+    } else {
+        std::printf("Simulating %u ticks: %u asteroids, %u players, fire period %u, thrust %.2f\n", settings.Ticks,
+                    settings.Asteroids, settings.Players, settings.FirePeriod, settings.Thrust);
+    }
+    std::printf("Particle kernels: %s\n", ParticleKernels::InstructionSet());
+    PrintCounts("init", CountEntities(simRegistry, *sim));
+
+    using Clock = SimTimings::Clock;
+    Clock::duration tickTotal = Clock::duration::zero();
+    Clock::duration tickMax = Clock::duration::zero();
+    uint32_t tick = 0;
+    uint32_t mismatches = 0;
+    uint32_t divergences = 0;
+    while (true) {
+        uint64_t expectedHash = 0;
+        if (replaying) {
+            if (!replay.Next(*gameInput, expectedHash)) {
+                break;
+            }
+        } else if (tick < settings.Ticks) {
+            ScriptInput(settings, tick, *gameInput);
+        } else {
+            break;
+        }
+
+        const Clock::time_point start = Clock::now();
+        sim->Tick();
+        const Clock::duration elapsed = Clock::now() - start;
+        tickTotal += elapsed;
+        tickMax = std::max(tickMax, elapsed);
+        tick += 1;
+
+        if (replaying || recorder.IsOpen()) {
+            const uint64_t hash = sim->StateHash();
+            if (replaying && hash != expectedHash) {
+                if (mismatches == 0) {
+                    std::printf("Replay diverged at tick %u\n", tick);
+                }
+                mismatches += 1;
+            }
+            if (recorder.IsOpen() && !recorder.Record(*gameInput, hash)) {
+                std::printf("Cannot write replay %s at tick %u\n", settings.RecordPath, tick);
+                return 1;
+            }
+        }
+        if (reference) {
+            reference->Tick();
+            if (sim->StateHash() != reference->StateHash()) {
+                if (divergences == 0) {
+                    std::printf("Diverged from the serial reference at tick %u\n", tick);
+                }
+                divergences += 1;
+            }
+        }
+
+        if (settings.ReportInterval > 0 && tick % settings.ReportInterval == 0) {
+            char label[16];
+            std::snprintf(label, sizeof(label), "%u", tick);
+            PrintCounts(label, CountEntities(simRegistry, *sim));
+        }
+    }
+    PrintCounts("final", CountEntities(simRegistry, *sim));
+    if (settings.SavePath != nullptr) {
+        sim->SaveSnapshot(snapshot);
+        if (!WriteSnapshotFile(settings.SavePath, snapshot)) {
+            std::printf("Cannot write snapshot %s\n", settings.SavePath);
+            return 1;
+        }
+        std::printf("Saved snapshot %s: %zu bytes\n", settings.SavePath, snapshot.size());
+    }
+    if (reference) {
+        std::printf("Serial reference %s: %u ticks, %u diverging\n", divergences == 0 ? "matched" : "FAILED", tick,
+                    divergences);
+    }
+    if (replaying) {
+        std::printf("Replay %s: %u ticks, %u mismatching hashes\n", mismatches == 0 ? "verified" : "FAILED", tick,
+                    mismatches);
+    }
+
+    using Millis = std::chrono::duration<double, std::milli>;
+    const double totalMs = Millis(tickTotal).count();
+    const double ticks = std::max<uint32_t>(tick, 1);
+    std::printf("\n%.1f ticks/s | mean %.3f ms | max %.3f ms | realtime budget %.3f ms\n",
+                1000.0 * ticks / std::max(totalMs, 1e-9), totalMs / ticks, Millis(tickMax).count(),
+                1000.0 * SimTimeData::DeltaTime);
+
+    std::printf("\n%-18s %12s %12s %7s\n", "Phase", "total ms", "ms/tick", "share");
+    for (size_t phase = 0; phase < timings.PhaseTimes.size(); ++phase) {
+        const double phaseMs = Millis(timings.PhaseTimes[phase]).count();
+        std::printf("%-18s %12.3f %12.4f %6.1f%%\n", SimTimings::PhaseName(static_cast<SimPhase>(phase)), phaseMs,
+                    phaseMs / ticks, 100.0 * phaseMs / std::max(totalMs, 1e-9));
+    }
+
+    return (mismatches == 0 && divergences == 0) ? 0 : 1;
+}
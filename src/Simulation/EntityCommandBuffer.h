@@ -0,0 +1,173 @@
+#pragma once
+
+#include "entt/entt.hpp"
+#include <stdint.h>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+// Entity created by a command buffer, only gets a registry entity on playback
+struct DeferredEntity
+{
+    uint32_t Index;
+};
+
+// Records structural changes (create, emplace, erase, destroy) so they can be made from worker threads while the
+// registry is being iterated, and applied later in bulk at a sync point. Each component type has its own streams,
+// so playback reserves once and batch inserts per type instead of growing storages entity by entity.
+// Playback order: creates, emplaces (in TComponents order), erases, destroys.
+template <typename... TComponents>
+class EntityCommandBuffer final
+{
+public:
+    DeferredEntity Create()
+    {
+        return {mCreateCount++};
+    }
+
+    // Like get_or_emplace: ignored when the entity already has the component, the first recorded value wins
+    template <typename T>
+    void Emplace(entt::entity entity, T value = {})
+    {
+        Stream<T>& stream = getStream<T>();
+        stream.Entities.push_back(entity);
+        stream.Values.push_back(std::move(value));
+    }
+
+    template <typename T>
+    void Emplace(DeferredEntity entity, T value = {})
+    {
+        Stream<T>& stream = getStream<T>();
+        stream.Created.push_back(entity.Index);
+        stream.CreatedValues.push_back(std::move(value));
+    }
+
+    template <typename T>
+    void Erase(entt::entity entity)
+    {
+        getStream<T>().Erased.push_back(entity);
+    }
+
+    void Destroy(entt::entity entity)
+    {
+        mDestroyed.push_back(entity);
+    }
+
+    bool Empty() const
+    {
+        auto streamsEmpty = [](const auto&... stream) {
+            return (stream.Empty() && ...);
+        };
+        return mCreateCount == 0 && mDestroyed.empty() && std::apply(streamsEmpty, mStreams);
+    }
+
+    // Applies and clears everything recorded, capacity is kept for the next tick. Storages with nothing recorded
+    // aren't touched, so buffers of systems running side by side only reach the storages they wrote to.
+    void Playback(entt::registry& registry)
+    {
+        if (mCreateCount > 0) {
+            mCreated.resize(mCreateCount);
+            registry.create(mCreated.begin(), mCreated.end());
+        }
+
+        auto emplaces = [&](auto&... stream) {
+            (playbackEmplaces(registry, stream), ...);
+        };
+        std::apply(emplaces, mStreams);
+        auto erases = [&](auto&... stream) {
+            (playbackErases(registry, stream), ...);
+        };
+        std::apply(erases, mStreams);
+
+        for (entt::entity entity : mDestroyed) {
+            // The same entity may have been recorded more than once
+            if (registry.valid(entity)) {
+                registry.destroy(entity);
+            }
+        }
+
+        auto clear = [](auto&... stream) {
+            (stream.Clear(), ...);
+        };
+        std::apply(clear, mStreams);
+        mDestroyed.clear();
+        mCreated.clear();
+        mCreateCount = 0;
+    }
+
+private:
+    template <typename T>
+    struct Stream
+    {
+        std::vector<entt::entity> Entities;
+        std::vector<T> Values;
+        std::vector<uint32_t> Created;
+        std::vector<T> CreatedValues;
+        std::vector<entt::entity> Erased;
+
+        bool Empty() const
+        {
+            return Entities.empty() && Created.empty() && Erased.empty();
+        }
+
+        void Clear()
+        {
+            Entities.clear();
+            Values.clear();
+            Created.clear();
+            CreatedValues.clear();
+            Erased.clear();
+        }
+    };
+
+    template <typename T>
+    Stream<T>& getStream()
+    {
+        return std::get<Stream<T>>(mStreams);
+    }
+
+    template <typename T>
+    void playbackEmplaces(entt::registry& registry, Stream<T>& stream)
+    {
+        if (stream.Entities.empty() && stream.Created.empty()) {
+            return;
+        }
+        auto& storage = registry.storage<T>();
+        storage.reserve(storage.size() + stream.Entities.size() + stream.Created.size());
+
+        // Fresh entities can't have the component yet, they go in with a single batch insert
+        if (!stream.Created.empty()) {
+            mResolved.clear();
+            for (uint32_t index : stream.Created) {
+                mResolved.push_back(mCreated[index]);
+            }
+            if constexpr (std::is_empty_v<T>) {
+                registry.insert<T>(mResolved.begin(), mResolved.end());
+            } else {
+                registry.insert<T>(mResolved.begin(), mResolved.end(), stream.CreatedValues.begin());
+            }
+        }
+
+        for (size_t i = 0; i < stream.Entities.size(); ++i) {
+            const entt::entity entity = stream.Entities[i];
+            if (registry.valid(entity) && !storage.contains(entity)) {
+                registry.emplace<T>(entity, std::move(stream.Values[i]));
+            }
+        }
+    }
+
+    template <typename T>
+    void playbackErases(entt::registry& registry, Stream<T>& stream)
+    {
+        if (stream.Erased.empty()) {
+            return;
+        }
+        registry.remove<T>(stream.Erased.begin(), stream.Erased.end());
+    }
+
+    std::tuple<Stream<TComponents>...> mStreams;
+    std::vector<entt::entity> mDestroyed;
+    std::vector<entt::entity> mCreated;
+    std::vector<entt::entity> mResolved;
+    uint32_t mCreateCount = 0;
+};
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "ThreadPool/ParallelFor.h"
+#include "entt/entt.hpp"
+#include <algorithm>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+// Chunk sizes are rounded up to this many entities, so chunk edges fall on cache line multiples of the view's leading
+// storage and neighbouring chunks don't write to the same lines of it. Components reached through the sparse lookup
+// aren't laid out in chunk order and get no such guarantee.
+constexpr size_t ParallelForEachAlignment = 64;
+constexpr size_t ParallelForEachChunk = 1024;
+
+namespace ParallelForEachInternal {
+constexpr size_t AlignChunk(size_t chunkSize)
+{
+    const size_t alignments = (std::max<size_t>(chunkSize, 1) + ParallelForEachAlignment - 1) /
+                              ParallelForEachAlignment;
+    return alignments * ParallelForEachAlignment;
+}
+
+template <typename TFunc, typename TTuple>
+struct IsApplicable;
+
+template <typename TFunc, typename... TArgs>
+struct IsApplicable<TFunc, std::tuple<TArgs...>> : std::is_invocable<TFunc, TArgs...>
+{};
+
+// Same call convention as view.each: the entity goes first when the function takes it, then non empty components
+template <typename TFunc, typename TPrefix, typename TComponents>
+void Invoke(TFunc& func, TPrefix prefix, entt::entity entity, TComponents components)
+{
+    auto withEntity = std::tuple_cat(prefix, std::make_tuple(entity), components);
+    if constexpr (IsApplicable<TFunc&, decltype(withEntity)>::value) {
+        std::apply(func, withEntity);
+    } else {
+        std::apply(func, std::tuple_cat(prefix, components));
+    }
+}
+
+// Walks the packed array of the view's leading storage by index, so it can be cut in chunks
+template <typename TView, typename TEntityAction>
+size_t RunViewChunks(ThreadPool& threadPool,
+                     std::vector<Task>& tasks,
+                     const TView& view,
+                     size_t chunkSize,
+                     TEntityAction&& entityAction)
+{
+    const entt::sparse_set& leading = view.handle();
+    const entt::entity* entities = leading.data();
+    const size_t count = leading.size();
+    chunkSize = AlignChunk(chunkSize);
+    auto chunkAction = [&](size_t chunkIndex, size_t first, size_t last) {
+        for (size_t index = first; index < last; ++index) {
+            const entt::entity entity = entities[index];
+            if (view.contains(entity)) {
+                entityAction(chunkIndex, entity);
+            }
+        }
+    };
+    RunChunks(threadPool, tasks, count, chunkSize, chunkAction);
+    return (count + chunkSize - 1) / chunkSize;
+}
+} // namespace ParallelForEachInternal
+
+// view.each spread over the pool. The function must only touch its own entity's components: no structural
+// changes to the registry, use ParallelForEachDeferred for those.
+template <typename TView, typename TFunc>
+void ParallelForEach(ThreadPool& threadPool,
+                     std::vector<Task>& tasks,
+                     const TView& view,
+                     TFunc&& func,
+                     size_t chunkSize = ParallelForEachChunk)
+{
+    auto entityAction = [&](size_t chunkIndex, entt::entity entity) {
+        ParallelForEachInternal::Invoke(func, std::tuple<>(), entity, view.get(entity));
+    };
+    ParallelForEachInternal::RunViewChunks(threadPool, tasks, view, chunkSize, entityAction);
+}
+
+// Same as ParallelForEach, the function also gets the command recorder of its chunk as first argument.
+// Returns the number of chunks, the caller plays commands[0, chunks) back in order once it's safe to, which
+// makes the result independent of the thread count.
+template <typename TView, typename TCommands, typename TFunc>
+size_t ParallelForEachDeferred(ThreadPool& threadPool,
+                               std::vector<Task>& tasks,
+                               const TView& view,
+                               std::vector<TCommands>& commands,
+                               TFunc&& func,
+                               size_t chunkSize = ParallelForEachChunk)
+{
+    const size_t alignedChunk = ParallelForEachInternal::AlignChunk(chunkSize);
+    const size_t chunks = (view.handle().size() + alignedChunk - 1) / alignedChunk;
+    if (commands.size() < chunks) {
+        commands.resize(chunks);
+    }
+    auto entityAction = [&](size_t chunkIndex, entt::entity entity) {
+        ParallelForEachInternal::Invoke(func, std::forward_as_tuple(commands[chunkIndex]), entity, view.get(entity));
+    };
+    return ParallelForEachInternal::RunViewChunks(threadPool, tasks, view, chunkSize, entityAction);
+}
@@ -0,0 +1,289 @@
+#include "ParticleKernels.h"
+
+#include "Data.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define PARTICLE_KERNELS_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PARTICLE_KERNELS_SSE2
+#endif
+
+namespace {
+struct KernelArrays
+{
+    float* PositionsX;
+    float* PositionsY;
+    float* PositionsZ;
+    float* VelocitiesX;
+    float* VelocitiesY;
+    float* VelocitiesZ;
+};
+
+// drag / speed == LinearDrag + QuadraticDrag * speed, which also leaves resting particles at rest
+size_t DragIntegrateWrapScalar(const KernelArrays& arrays, size_t first, size_t last, float deltaTime)
+{
+    for (size_t index = first; index < last; ++index) {
+        float vx = arrays.VelocitiesX[index];
+        float vy = arrays.VelocitiesY[index];
+        float vz = arrays.VelocitiesZ[index];
+        const float speed = std::sqrt(vx * vx + vy * vy + vz * vz);
+        const float scale = 1.f - (ParticleData::LinearDrag + ParticleData::QuadraticDrag * speed);
+        vx *= scale;
+        vy *= scale;
+        vz *= scale;
+        arrays.VelocitiesX[index] = vx;
+        arrays.VelocitiesY[index] = vy;
+        arrays.VelocitiesZ[index] = vz;
+
+        float x = arrays.PositionsX[index] + vx * deltaTime;
+        float z = arrays.PositionsZ[index] + vz * deltaTime;
+        arrays.PositionsY[index] += vy * deltaTime;
+        if (x < 0.f) {
+            x += SpaceData::LengthX;
+        } else if (x > SpaceData::LengthX) {
+            x -= SpaceData::LengthX;
+        }
+        if (z < 0.f) {
+            z += SpaceData::LengthZ;
+        } else if (z > SpaceData::LengthZ) {
+            z -= SpaceData::LengthZ;
+        }
+        arrays.PositionsX[index] = x;
+        arrays.PositionsZ[index] = z;
+    }
+    return last;
+}
+
+// Zero length directions stay zero, like Vector3Normalize: clamping the squared length keeps 0 * (1 / sqrt) finite
+size_t RadialBurstScalar(const KernelArrays& arrays, size_t first, size_t last, const Vector3& origin,
+                         const Vector3& baseVelocity, float offset, float force)
+{
+    for (size_t index = first; index < last; ++index) {
+        const float dx = arrays.VelocitiesX[index];
+        const float dy = arrays.VelocitiesY[index];
+        const float dz = arrays.VelocitiesZ[index];
+        const float inverseLength = 1.f / std::sqrt(std::max(dx * dx + dy * dy + dz * dz, FLT_MIN));
+        const float rx = dx * inverseLength;
+        const float ry = dy * inverseLength;
+        const float rz = dz * inverseLength;
+        arrays.PositionsX[index] = origin.x + rx * offset;
+        arrays.PositionsY[index] = origin.y + ry * offset;
+        arrays.PositionsZ[index] = origin.z + rz * offset;
+        arrays.VelocitiesX[index] = baseVelocity.x + rx * force;
+        arrays.VelocitiesY[index] = baseVelocity.y + ry * force;
+        arrays.VelocitiesZ[index] = baseVelocity.z + rz * force;
+    }
+    return last;
+}
+
+#if defined(PARTICLE_KERNELS_AVX2)
+size_t DragIntegrateWrapAVX2(const KernelArrays& arrays, size_t first, size_t last, float deltaTime)
+{
+    constexpr size_t Width = 8;
+    const __m256 one = _mm256_set1_ps(1.f);
+    const __m256 linearDrag = _mm256_set1_ps(ParticleData::LinearDrag);
+    const __m256 quadraticDrag = _mm256_set1_ps(ParticleData::QuadraticDrag);
+    const __m256 dt = _mm256_set1_ps(deltaTime);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 lengthX = _mm256_set1_ps(SpaceData::LengthX);
+    const __m256 lengthZ = _mm256_set1_ps(SpaceData::LengthZ);
+
+    size_t index = first;
+    for (; index + Width <= last; index += Width) {
+        __m256 vx = _mm256_loadu_ps(arrays.VelocitiesX + index);
+        __m256 vy = _mm256_loadu_ps(arrays.VelocitiesY + index);
+        __m256 vz = _mm256_loadu_ps(arrays.VelocitiesZ + index);
+        const __m256 speedSqr =
+        _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy)), _mm256_mul_ps(vz, vz));
+        const __m256 speed = _mm256_sqrt_ps(speedSqr);
+        const __m256 scale = _mm256_sub_ps(one, _mm256_add_ps(linearDrag, _mm256_mul_ps(quadraticDrag, speed)));
+        vx = _mm256_mul_ps(vx, scale);
+        vy = _mm256_mul_ps(vy, scale);
+        vz = _mm256_mul_ps(vz, scale);
+        _mm256_storeu_ps(arrays.VelocitiesX + index, vx);
+        _mm256_storeu_ps(arrays.VelocitiesY + index, vy);
+        _mm256_storeu_ps(arrays.VelocitiesZ + index, vz);
+
+        __m256 x = _mm256_add_ps(_mm256_loadu_ps(arrays.PositionsX + index), _mm256_mul_ps(vx, dt));
+        const __m256 y = _mm256_add_ps(_mm256_loadu_ps(arrays.PositionsY + index), _mm256_mul_ps(vy, dt));
+        __m256 z = _mm256_add_ps(_mm256_loadu_ps(arrays.PositionsZ + index), _mm256_mul_ps(vz, dt));
+
+        // Branchless wrap: add the length where below zero, subtract it where above
+        x = _mm256_add_ps(x, _mm256_and_ps(_mm256_cmp_ps(x, zero, _CMP_LT_OQ), lengthX));
+        x = _mm256_sub_ps(x, _mm256_and_ps(_mm256_cmp_ps(x, lengthX, _CMP_GT_OQ), lengthX));
+        z = _mm256_add_ps(z, _mm256_and_ps(_mm256_cmp_ps(z, zero, _CMP_LT_OQ), lengthZ));
+        z = _mm256_sub_ps(z, _mm256_and_ps(_mm256_cmp_ps(z, lengthZ, _CMP_GT_OQ), lengthZ));
+
+        _mm256_storeu_ps(arrays.PositionsX + index, x);
+        _mm256_storeu_ps(arrays.PositionsY + index, y);
+        _mm256_storeu_ps(arrays.PositionsZ + index, z);
+    }
+    return index;
+}
+
+size_t RadialBurstAVX2(const KernelArrays& arrays, size_t first, size_t last, const Vector3& origin,
+                       const Vector3& baseVelocity, float offset, float force)
+{
+    constexpr size_t Width = 8;
+    const __m256 one = _mm256_set1_ps(1.f);
+    const __m256 minLengthSqr = _mm256_set1_ps(FLT_MIN);
+    const __m256 offsetScale = _mm256_set1_ps(offset);
+    const __m256 forceScale = _mm256_set1_ps(force);
+    const __m256 originX = _mm256_set1_ps(origin.x);
+    const __m256 originY = _mm256_set1_ps(origin.y);
+    const __m256 originZ = _mm256_set1_ps(origin.z);
+    const __m256 velocityX = _mm256_set1_ps(baseVelocity.x);
+    const __m256 velocityY = _mm256_set1_ps(baseVelocity.y);
+    const __m256 velocityZ = _mm256_set1_ps(baseVelocity.z);
+
+    size_t index = first;
+    for (; index + Width <= last; index += Width) {
+        const __m256 dx = _mm256_loadu_ps(arrays.VelocitiesX + index);
+        const __m256 dy = _mm256_loadu_ps(arrays.VelocitiesY + index);
+        const __m256 dz = _mm256_loadu_ps(arrays.VelocitiesZ + index);
+        const __m256 lengthSqr =
+        _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+        const __m256 inverseLength = _mm256_div_ps(one, _mm256_sqrt_ps(_mm256_max_ps(lengthSqr, minLengthSqr)));
+        const __m256 rx = _mm256_mul_ps(dx, inverseLength);
+        const __m256 ry = _mm256_mul_ps(dy, inverseLength);
+        const __m256 rz = _mm256_mul_ps(dz, inverseLength);
+        _mm256_storeu_ps(arrays.PositionsX + index, _mm256_add_ps(originX, _mm256_mul_ps(rx, offsetScale)));
+        _mm256_storeu_ps(arrays.PositionsY + index, _mm256_add_ps(originY, _mm256_mul_ps(ry, offsetScale)));
+        _mm256_storeu_ps(arrays.PositionsZ + index, _mm256_add_ps(originZ, _mm256_mul_ps(rz, offsetScale)));
+        _mm256_storeu_ps(arrays.VelocitiesX + index, _mm256_add_ps(velocityX, _mm256_mul_ps(rx, forceScale)));
+        _mm256_storeu_ps(arrays.VelocitiesY + index, _mm256_add_ps(velocityY, _mm256_mul_ps(ry, forceScale)));
+        _mm256_storeu_ps(arrays.VelocitiesZ + index, _mm256_add_ps(velocityZ, _mm256_mul_ps(rz, forceScale)));
+    }
+    return index;
+}
+#endif
+
+#if defined(PARTICLE_KERNELS_SSE2)
+size_t DragIntegrateWrapSSE2(const KernelArrays& arrays, size_t first, size_t last, float deltaTime)
+{
+    constexpr size_t Width = 4;
+    const __m128 one = _mm_set1_ps(1.f);
+    const __m128 linearDrag = _mm_set1_ps(ParticleData::LinearDrag);
+    const __m128 quadraticDrag = _mm_set1_ps(ParticleData::QuadraticDrag);
+    const __m128 dt = _mm_set1_ps(deltaTime);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 lengthX = _mm_set1_ps(SpaceData::LengthX);
+    const __m128 lengthZ = _mm_set1_ps(SpaceData::LengthZ);
+
+    size_t index = first;
+    for (; index + Width <= last; index += Width) {
+        __m128 vx = _mm_loadu_ps(arrays.VelocitiesX + index);
+        __m128 vy = _mm_loadu_ps(arrays.VelocitiesY + index);
+        __m128 vz = _mm_loadu_ps(arrays.VelocitiesZ + index);
+        const __m128 speedSqr = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz));
+        const __m128 speed = _mm_sqrt_ps(speedSqr);
+        const __m128 scale = _mm_sub_ps(one, _mm_add_ps(linearDrag, _mm_mul_ps(quadraticDrag, speed)));
+        vx = _mm_mul_ps(vx, scale);
+        vy = _mm_mul_ps(vy, scale);
+        vz = _mm_mul_ps(vz, scale);
+        _mm_storeu_ps(arrays.VelocitiesX + index, vx);
+        _mm_storeu_ps(arrays.VelocitiesY + index, vy);
+        _mm_storeu_ps(arrays.VelocitiesZ + index, vz);
+
+        __m128 x = _mm_add_ps(_mm_loadu_ps(arrays.PositionsX + index), _mm_mul_ps(vx, dt));
+        const __m128 y = _mm_add_ps(_mm_loadu_ps(arrays.PositionsY + index), _mm_mul_ps(vy, dt));
+        __m128 z = _mm_add_ps(_mm_loadu_ps(arrays.PositionsZ + index), _mm_mul_ps(vz, dt));
+
+        x = _mm_add_ps(x, _mm_and_ps(_mm_cmplt_ps(x, zero), lengthX));
+        x = _mm_sub_ps(x, _mm_and_ps(_mm_cmpgt_ps(x, lengthX), lengthX));
+        z = _mm_add_ps(z, _mm_and_ps(_mm_cmplt_ps(z, zero), lengthZ));
+        z = _mm_sub_ps(z, _mm_and_ps(_mm_cmpgt_ps(z, lengthZ), lengthZ));
+
+        _mm_storeu_ps(arrays.PositionsX + index, x);
+        _mm_storeu_ps(arrays.PositionsY + index, y);
+        _mm_storeu_ps(arrays.PositionsZ + index, z);
+    }
+    return index;
+}
+
+size_t RadialBurstSSE2(const KernelArrays& arrays, size_t first, size_t last, const Vector3& origin,
+                       const Vector3& baseVelocity, float offset, float force)
+{
+    constexpr size_t Width = 4;
+    const __m128 one = _mm_set1_ps(1.f);
+    const __m128 minLengthSqr = _mm_set1_ps(FLT_MIN);
+    const __m128 offsetScale = _mm_set1_ps(offset);
+    const __m128 forceScale = _mm_set1_ps(force);
+    const __m128 originX = _mm_set1_ps(origin.x);
+    const __m128 originY = _mm_set1_ps(origin.y);
+    const __m128 originZ = _mm_set1_ps(origin.z);
+    const __m128 velocityX = _mm_set1_ps(baseVelocity.x);
+    const __m128 velocityY = _mm_set1_ps(baseVelocity.y);
+    const __m128 velocityZ = _mm_set1_ps(baseVelocity.z);
+
+    size_t index = first;
+    for (; index + Width <= last; index += Width) {
+        const __m128 dx = _mm_loadu_ps(arrays.VelocitiesX + index);
+        const __m128 dy = _mm_loadu_ps(arrays.VelocitiesY + index);
+        const __m128 dz = _mm_loadu_ps(arrays.VelocitiesZ + index);
+        const __m128 lengthSqr = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+        const __m128 inverseLength = _mm_div_ps(one, _mm_sqrt_ps(_mm_max_ps(lengthSqr, minLengthSqr)));
+        const __m128 rx = _mm_mul_ps(dx, inverseLength);
+        const __m128 ry = _mm_mul_ps(dy, inverseLength);
+        const __m128 rz = _mm_mul_ps(dz, inverseLength);
+        _mm_storeu_ps(arrays.PositionsX + index, _mm_add_ps(originX, _mm_mul_ps(rx, offsetScale)));
+        _mm_storeu_ps(arrays.PositionsY + index, _mm_add_ps(originY, _mm_mul_ps(ry, offsetScale)));
+        _mm_storeu_ps(arrays.PositionsZ + index, _mm_add_ps(originZ, _mm_mul_ps(rz, offsetScale)));
+        _mm_storeu_ps(arrays.VelocitiesX + index, _mm_add_ps(velocityX, _mm_mul_ps(rx, forceScale)));
+        _mm_storeu_ps(arrays.VelocitiesY + index, _mm_add_ps(velocityY, _mm_mul_ps(ry, forceScale)));
+        _mm_storeu_ps(arrays.VelocitiesZ + index, _mm_add_ps(velocityZ, _mm_mul_ps(rz, forceScale)));
+    }
+    return index;
+}
+#endif
+} // namespace
+
+namespace ParticleKernels {
+void DragIntegrateWrap(ParticlePool& particles, size_t first, size_t last, float deltaTime)
+{
+    const KernelArrays arrays = {particles.PositionsX.data(),  particles.PositionsY.data(),
+                                 particles.PositionsZ.data(),  particles.VelocitiesX.data(),
+                                 particles.VelocitiesY.data(), particles.VelocitiesZ.data()};
+    size_t index = first;
+#if defined(PARTICLE_KERNELS_AVX2)
+    index = DragIntegrateWrapAVX2(arrays, index, last, deltaTime);
+#endif
+#if defined(PARTICLE_KERNELS_SSE2)
+    index = DragIntegrateWrapSSE2(arrays, index, last, deltaTime);
+#endif
+    DragIntegrateWrapScalar(arrays, index, last, deltaTime);
+}
+
+void RadialBurst(ParticlePool& particles, size_t first, size_t last, const Vector3& origin,
+                 const Vector3& baseVelocity, float offset, float force)
+{
+    const KernelArrays arrays = {particles.PositionsX.data(),  particles.PositionsY.data(),
+                                 particles.PositionsZ.data(),  particles.VelocitiesX.data(),
+                                 particles.VelocitiesY.data(), particles.VelocitiesZ.data()};
+    size_t index = first;
+#if defined(PARTICLE_KERNELS_AVX2)
+    index = RadialBurstAVX2(arrays, index, last, origin, baseVelocity, offset, force);
+#endif
+#if defined(PARTICLE_KERNELS_SSE2)
+    index = RadialBurstSSE2(arrays, index, last, origin, baseVelocity, offset, force);
+#endif
+    RadialBurstScalar(arrays, index, last, origin, baseVelocity, offset, force);
+}
+
+const char* InstructionSet()
+{
+#if defined(PARTICLE_KERNELS_AVX2)
+    return "AVX2";
+#elif defined(PARTICLE_KERNELS_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+} // namespace ParticleKernels
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "ParticlePool.h"
+
+namespace ParticleKernels {
+// Applies drag, integrates positions and wraps them to the torus for particles in [first, last), in one sweep.
+// Uses AVX2 when the build enables it, SSE2 otherwise on x86, and scalar code for the tail and other targets.
+void DragIntegrateWrap(ParticlePool& particles, size_t first, size_t last, float deltaTime);
+
+// Turns the random directions stored in the velocities of [first, last) into a burst: each particle is placed at
+// offset along its normalized direction from origin, moving at force along it on top of baseVelocity.
+void RadialBurst(ParticlePool& particles, size_t first, size_t last, const Vector3& origin,
+                 const Vector3& baseVelocity, float offset, float force);
+
+// Name of the widest instruction set the kernels were built with
+const char* InstructionSet();
+} // namespace ParticleKernels
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <array>
+#include <assert.h>
+#include <raylib.h>
+#include <stdint.h>
+#include <vector>
+
+// Cosmetic particles (thrust exhaust, explosion debris) kept out of the registry as parallel arrays.
+// Indices are not stable: removing a particle moves the last one into its slot.
+class ParticlePool
+{
+public:
+    std::vector<float> PositionsX;
+    std::vector<float> PositionsY;
+    std::vector<float> PositionsZ;
+    std::vector<float> VelocitiesX;
+    std::vector<float> VelocitiesY;
+    std::vector<float> VelocitiesZ;
+    std::vector<float> LifeTimes;
+    std::vector<Color> Colors;
+
+    size_t Size() const
+    {
+        return LifeTimes.size();
+    }
+
+    // Every float array, in declaration order
+    std::array<std::vector<float>*, 7> FloatColumns()
+    {
+        return {&PositionsX, &PositionsY, &PositionsZ, &VelocitiesX, &VelocitiesY, &VelocitiesZ, &LifeTimes};
+    }
+
+    std::array<const std::vector<float>*, 7> FloatColumns() const
+    {
+        return {&PositionsX, &PositionsY, &PositionsZ, &VelocitiesX, &VelocitiesY, &VelocitiesZ, &LifeTimes};
+    }
+
+    void Reserve(size_t capacity)
+    {
+        PositionsX.reserve(capacity);
+        PositionsY.reserve(capacity);
+        PositionsZ.reserve(capacity);
+        VelocitiesX.reserve(capacity);
+        VelocitiesY.reserve(capacity);
+        VelocitiesZ.reserve(capacity);
+        LifeTimes.reserve(capacity);
+        Colors.reserve(capacity);
+    }
+
+    void Clear()
+    {
+        PositionsX.clear();
+        PositionsY.clear();
+        PositionsZ.clear();
+        VelocitiesX.clear();
+        VelocitiesY.clear();
+        VelocitiesZ.clear();
+        LifeTimes.clear();
+        Colors.clear();
+    }
+
+    void Add(const Vector3& position, const Vector3& velocity, float lifeTime, Color color)
+    {
+        PositionsX.push_back(position.x);
+        PositionsY.push_back(position.y);
+        PositionsZ.push_back(position.z);
+        VelocitiesX.push_back(velocity.x);
+        VelocitiesY.push_back(velocity.y);
+        VelocitiesZ.push_back(velocity.z);
+        LifeTimes.push_back(lifeTime);
+        Colors.push_back(color);
+    }
+
+    // Appends count particles in one growth per array and returns the index of the first one, the caller fills them
+    size_t Grow(size_t count, Color color)
+    {
+        const size_t first = Size();
+        const size_t size = first + count;
+        PositionsX.resize(size);
+        PositionsY.resize(size);
+        PositionsZ.resize(size);
+        VelocitiesX.resize(size);
+        VelocitiesY.resize(size);
+        VelocitiesZ.resize(size);
+        LifeTimes.resize(size);
+        Colors.resize(size, color);
+        return first;
+    }
+
+    void SwapRemove(size_t index)
+    {
+        assert(index < Size());
+        const size_t last = Size() - 1;
+        PositionsX[index] = PositionsX[last];
+        PositionsY[index] = PositionsY[last];
+        PositionsZ[index] = PositionsZ[last];
+        VelocitiesX[index] = VelocitiesX[last];
+        VelocitiesY[index] = VelocitiesY[last];
+        VelocitiesZ[index] = VelocitiesZ[last];
+        LifeTimes[index] = LifeTimes[last];
+        Colors[index] = Colors[last];
+        PositionsX.pop_back();
+        PositionsY.pop_back();
+        PositionsZ.pop_back();
+        VelocitiesX.pop_back();
+        VelocitiesY.pop_back();
+        VelocitiesZ.pop_back();
+        LifeTimes.pop_back();
+        Colors.pop_back();
+    }
+
+    Vector3 GetPosition(size_t index) const
+    {
+        return {PositionsX[index], PositionsY[index], PositionsZ[index]};
+    }
+
+    Vector3 GetVelocity(size_t index) const
+    {
+        return {VelocitiesX[index], VelocitiesY[index], VelocitiesZ[index]};
+    }
+
+    void SetVelocity(size_t index, const Vector3& velocity)
+    {
+        VelocitiesX[index] = velocity.x;
+        VelocitiesY[index] = velocity.y;
+        VelocitiesZ[index] = velocity.z;
+    }
+};
@@ -0,0 +1,181 @@
+#include "Replay.h"
+
+static constexpr uint32_t ReplayMagic = 0x594C5052; // "RPLY"
+static constexpr uint32_t ReplayVersion = 2; // 2: order independent state hash
+
+static constexpr uint8_t StickChangedBit = 1u << 0; // Shifted by the player index
+static constexpr uint8_t FireBit = 1u << 2;         // Shifted by the player index
+
+// Raw host representation, logs are meant to be replayed on the same kind of machine they were recorded on
+template <typename T>
+static bool WriteValue(FILE* file, const T& value)
+{
+    return std::fwrite(&value, sizeof(T), 1, file) == 1;
+}
+
+template <typename T>
+static bool ReadValue(FILE* file, T& value)
+{
+    return std::fread(&value, sizeof(T), 1, file) == 1;
+}
+
+static bool SticksEqual(const GameInput& a, const GameInput& b)
+{
+    return a.Forward == b.Forward && a.Left == b.Left && a.SecondaryForward == b.SecondaryForward &&
+           a.SecondaryLeft == b.SecondaryLeft;
+}
+
+ReplayHeader ReplayHeader::FromSettings(const SimSettings& settings, uint32_t players, uint32_t asteroids)
+{
+    ReplayHeader header;
+    header.Seed = settings.Seed;
+    header.Players = players;
+    header.Asteroids = asteroids;
+    header.Broadphase = settings.Broadphase;
+    header.IncrementalPartition = settings.IncrementalPartition;
+    return header;
+}
+
+void ReplayHeader::ApplyTo(SimSettings& settings) const
+{
+    settings.Seed = Seed;
+    settings.Broadphase = Broadphase;
+    settings.IncrementalPartition = IncrementalPartition;
+}
+
+ReplayRecorder::~ReplayRecorder()
+{
+    Close();
+}
+
+bool ReplayRecorder::Open(const char* path, const ReplayHeader& header)
+{
+    Close();
+    mFile = std::fopen(path, "wb");
+    if (mFile == nullptr) {
+        return false;
+    }
+    mPreviousInput = {};
+    const bool written = WriteValue(mFile, ReplayMagic) && WriteValue(mFile, ReplayVersion) &&
+                         WriteValue(mFile, header.Seed) && WriteValue(mFile, header.Players) &&
+                         WriteValue(mFile, header.Asteroids) &&
+                         WriteValue(mFile, static_cast<uint8_t>(header.Broadphase)) &&
+                         WriteValue(mFile, static_cast<uint8_t>(header.IncrementalPartition));
+    if (!written) {
+        Close();
+    }
+    return written;
+}
+
+void ReplayRecorder::Close()
+{
+    if (mFile != nullptr) {
+        std::fclose(mFile);
+        mFile = nullptr;
+    }
+}
+
+bool ReplayRecorder::IsOpen() const
+{
+    return mFile != nullptr;
+}
+
+bool ReplayRecorder::Record(const std::array<GameInput, 2>& input, uint64_t stateHash)
+{
+    if (mFile == nullptr) {
+        return false;
+    }
+    uint8_t flags = 0;
+    for (uint32_t player = 0; player < input.size(); ++player) {
+        if (!SticksEqual(input[player], mPreviousInput[player])) {
+            flags |= StickChangedBit << player;
+        }
+        if (input[player].Fire) {
+            flags |= FireBit << player;
+        }
+    }
+    bool written = WriteValue(mFile, flags);
+    for (uint32_t player = 0; player < input.size() && written; ++player) {
+        if (flags & (StickChangedBit << player)) {
+            const GameInput& playerInput = input[player];
+            written = WriteValue(mFile, playerInput.Forward) && WriteValue(mFile, playerInput.Left) &&
+                      WriteValue(mFile, playerInput.SecondaryForward) && WriteValue(mFile, playerInput.SecondaryLeft);
+        }
+    }
+    written = written && WriteValue(mFile, stateHash);
+    if (!written) {
+        Close();
+        return false;
+    }
+    mPreviousInput = input;
+    return true;
+}
+
+ReplayReader::~ReplayReader()
+{
+    Close();
+}
+
+bool ReplayReader::Open(const char* path)
+{
+    Close();
+    mFile = std::fopen(path, "rb");
+    if (mFile == nullptr) {
+        return false;
+    }
+    mPreviousInput = {};
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    uint8_t broadphase = 0;
+    uint8_t incrementalPartition = 0;
+    const bool read = ReadValue(mFile, magic) && ReadValue(mFile, version) && ReadValue(mFile, mHeader.Seed) &&
+                      ReadValue(mFile, mHeader.Players) && ReadValue(mFile, mHeader.Asteroids) &&
+                      ReadValue(mFile, broadphase) && ReadValue(mFile, incrementalPartition);
+    if (!read || magic != ReplayMagic || version != ReplayVersion ||
+        broadphase > static_cast<uint8_t>(BroadphaseMode::ParallelMinCorner)) {
+        Close();
+        return false;
+    }
+    mHeader.Broadphase = static_cast<BroadphaseMode>(broadphase);
+    mHeader.IncrementalPartition = incrementalPartition != 0;
+    return true;
+}
+
+void ReplayReader::Close()
+{
+    if (mFile != nullptr) {
+        std::fclose(mFile);
+        mFile = nullptr;
+    }
+}
+
+const ReplayHeader& ReplayReader::Header() const
+{
+    return mHeader;
+}
+
+bool ReplayReader::Next(std::array<GameInput, 2>& input, uint64_t& stateHash)
+{
+    uint8_t flags = 0;
+    if (mFile == nullptr || !ReadValue(mFile, flags)) {
+        return false;
+    }
+    input = mPreviousInput;
+    for (uint32_t player = 0; player < input.size(); ++player) {
+        GameInput& playerInput = input[player];
+        if (flags & (StickChangedBit << player)) {
+            const bool read = ReadValue(mFile, playerInput.Forward) && ReadValue(mFile, playerInput.Left) &&
+                              ReadValue(mFile, playerInput.SecondaryForward) &&
+                              ReadValue(mFile, playerInput.SecondaryLeft);
+            if (!read) {
+                return false;
+            }
+        }
+        playerInput.Fire = (flags & (FireBit << player)) != 0;
+    }
+    if (!ReadValue(mFile, stateHash)) {
+        return false;
+    }
+    mPreviousInput = input;
+    return true;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Data.h"
+#include "Simulation.h"
+#include <array>
+#include <cstdio>
+#include <stdint.h>
+
+// Everything besides the per tick input a run depends on
+struct ReplayHeader
+{
+    uint64_t Seed = 0;
+    uint32_t Players = 0;
+    uint32_t Asteroids = 0;
+    BroadphaseMode Broadphase = BroadphaseMode::SortedDedup;
+    bool IncrementalPartition = false;
+
+    static ReplayHeader FromSettings(const SimSettings& settings, uint32_t players, uint32_t asteroids);
+    // Overrides the settings that change results, the others (ParallelSystems...) are left as they are
+    void ApplyTo(SimSettings& settings) const;
+};
+
+// Binary input log: a header, then per tick a byte of flags (which players' sticks changed, the fire buttons),
+// the sticks that changed since the previous tick and the state hash after the tick.
+class ReplayRecorder final
+{
+public:
+    ~ReplayRecorder();
+
+    bool Open(const char* path, const ReplayHeader& header);
+    void Close();
+    bool IsOpen() const;
+
+    // Input the tick ran with, and Simulation::StateHash after it. False when not open or the write fails, the
+    // recorder is then closed and the log ends truncated.
+    bool Record(const std::array<GameInput, 2>& input, uint64_t stateHash);
+
+private:
+    FILE* mFile = nullptr;
+    std::array<GameInput, 2> mPreviousInput = {};
+};
+
+class ReplayReader final
+{
+public:
+    ~ReplayReader();
+
+    bool Open(const char* path);
+    void Close();
+    const ReplayHeader& Header() const;
+
+    // False once the log is exhausted
+    bool Next(std::array<GameInput, 2>& input, uint64_t& stateHash);
+
+private:
+    FILE* mFile = nullptr;
+    ReplayHeader mHeader;
+    std::array<GameInput, 2> mPreviousInput = {};
+};
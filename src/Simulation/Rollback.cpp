@@ -0,0 +1,140 @@
+#include "Rollback.h"
+#include <algorithm>
+#include <cassert>
+#include <tracy/Tracy.hpp>
+
+static bool InputsEqual(const GameInput& a, const GameInput& b)
+{
+    return a.Forward == b.Forward && a.Left == b.Left && a.SecondaryForward == b.SecondaryForward &&
+           a.SecondaryLeft == b.SecondaryLeft && a.Fire == b.Fire;
+}
+
+RollbackSession::RollbackSession(Simulation& simulation, std::array<GameInput, 2>& input, uint32_t localPlayer)
+: mSimulation(simulation), mInput(input), mLocalPlayer(localPlayer), mRemotePlayer(1 - localPlayer)
+{}
+
+void RollbackSession::Start()
+{
+    assert(!mSimulation.Settings.IncrementalPartition);
+    for (Frame& frame : mFrames) {
+        frame.Tick = NoTick;
+        frame.RemoteConfirmed = false;
+    }
+    mConfirmedTick = mSimulation.GetFrame();
+    mRollbackTick = NoTick;
+    mFailed = false;
+    mLastRemoteInput = {};
+    mStats = {};
+}
+
+bool RollbackSession::Advance(const GameInput& localInput)
+{
+    ZoneScoped;
+    const uint32_t tick = mSimulation.GetFrame();
+    if (tick >= mConfirmedTick + RollbackWindow) {
+        mStats.Stalls += 1;
+        return false;
+    }
+    if (!Resimulate()) {
+        return false;
+    }
+
+    Frame& frame = frameAt(tick);
+    if (frame.Tick != tick) {
+        frame.Tick = tick;
+        frame.RemoteConfirmed = false;
+    }
+    frame.Input[mLocalPlayer] = localInput;
+    if (!frame.RemoteConfirmed) {
+        frame.Input[mRemotePlayer] = mLastRemoteInput;
+    }
+    simulate(frame, true);
+    return true;
+}
+
+bool RollbackSession::AddRemoteInput(uint32_t tick, const GameInput& input)
+{
+    const uint32_t current = mSimulation.GetFrame();
+    if (tick != mConfirmedTick || tick >= current + RollbackWindow) {
+        return false;
+    }
+    Frame& frame = frameAt(tick);
+    if (tick < current) {
+        if (!InputsEqual(frame.Input[mRemotePlayer], input)) {
+            mRollbackTick = std::min(mRollbackTick, tick);
+        }
+    } else {
+        frame.Tick = tick;
+    }
+    frame.Input[mRemotePlayer] = input;
+    frame.RemoteConfirmed = true;
+    mLastRemoteInput = input;
+    mConfirmedTick += 1;
+    return true;
+}
+
+bool RollbackSession::Resimulate()
+{
+    if (mFailed) {
+        return false;
+    }
+    const uint32_t current = mSimulation.GetFrame();
+    if (mRollbackTick >= current) {
+        return true;
+    }
+    ZoneScoped;
+    const uint32_t depth = current - mRollbackTick;
+    Frame& first = frameAt(mRollbackTick);
+    if (!mSimulation.LoadSnapshot(first.Snapshot.data(), first.Snapshot.size())) {
+        mFailed = true;
+        return false;
+    }
+    for (uint32_t tick = mRollbackTick; tick < current; ++tick) {
+        Frame& frame = frameAt(tick);
+        // Ticks past the confirmed ones get the newest prediction
+        if (!frame.RemoteConfirmed) {
+            frame.Input[mRemotePlayer] = mLastRemoteInput;
+        }
+        // The first tick's snapshot is what was just loaded
+        simulate(frame, tick != mRollbackTick);
+    }
+    mRollbackTick = NoTick;
+    mStats.Rollbacks += 1;
+    mStats.ResimulatedTicks += depth;
+    mStats.MaxDepth = std::max(mStats.MaxDepth, depth);
+    return true;
+}
+
+uint32_t RollbackSession::CurrentTick() const
+{
+    return mSimulation.GetFrame();
+}
+
+uint32_t RollbackSession::ConfirmedTick() const
+{
+    return mConfirmedTick;
+}
+
+const RollbackStats& RollbackSession::Stats() const
+{
+    return mStats;
+}
+
+bool RollbackSession::Failed() const
+{
+    return mFailed;
+}
+
+RollbackSession::Frame& RollbackSession::frameAt(uint32_t tick)
+{
+    return mFrames[tick % RollbackRingSize];
+}
+
+void RollbackSession::simulate(Frame& frame, bool saveSnapshot)
+{
+    if (saveSnapshot) {
+        mSimulation.SaveSnapshot(frame.Snapshot);
+    }
+    mInput = frame.Input;
+    mSimulation.Tick();
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "Data.h"
+#include "Simulation.h"
+#include <array>
+#include <stdint.h>
+#include <vector>
+
+constexpr uint32_t RollbackWindow = 8; // Most ticks a late input can roll back
+// Inputs may arrive up to a window ahead, snapshots are only needed for the window behind
+constexpr uint32_t RollbackRingSize = 2 * RollbackWindow;
+
+struct RollbackStats
+{
+    uint32_t Rollbacks = 0;
+    uint32_t ResimulatedTicks = 0;
+    uint32_t MaxDepth = 0;
+    uint32_t Stalls = 0; // Advance calls refused for being a window ahead of the remote input
+};
+
+// Two player session over a deterministic Simulation. The local input of each tick is known, the remote one is
+// predicted as the last one received. Each tick keeps the snapshot of the state it started from, so when remote
+// input arrives that differs from its prediction, the state is restored to that tick and re-simulated up to the
+// present with the corrected input. Snapshot buffers live in a ring and are reused, a tick saves without allocating.
+// Incremental partition mode isn't supported: snapshots don't keep its slot layout, so a restored run visits pairs in
+// a different order than the original one and drifts apart from it.
+class RollbackSession final
+{
+public:
+    // input is the array the simulation reads, the session fills it before every tick
+    RollbackSession(Simulation& simulation, std::array<GameInput, 2>& input, uint32_t localPlayer);
+
+    // Starts from the simulation's current state, after Init or LoadSnapshot. IncrementalPartition must be off.
+    void Start();
+
+    // Simulates one tick. False, without simulating, when it would get further ahead of the last confirmed remote
+    // input than a rollback can reach: the caller waits for the remote and tries again. Also false once a rollback
+    // failed, see Failed.
+    bool Advance(const GameInput& localInput);
+
+    // Remote input has to come in tick order. False when tick isn't the next expected one or is a window or more
+    // ahead, which stalling on both ends rules out. The correction, if any, is applied on the next Advance or
+    // Resimulate.
+    bool AddRemoteInput(uint32_t tick, const GameInput& input);
+
+    // Applies pending corrections right away, for instance to compare states once all input is known. False when the
+    // snapshot to roll back to can't be loaded, the state is left as it was and the session is failed for good.
+    bool Resimulate();
+
+    // Next tick to simulate
+    uint32_t CurrentTick() const;
+    // Ticks below this one ran with the actual remote input
+    uint32_t ConfirmedTick() const;
+    const RollbackStats& Stats() const;
+    // A rollback couldn't restore its snapshot, the state no longer matches the peer's
+    bool Failed() const;
+
+private:
+    static constexpr uint32_t NoTick = ~0u;
+
+    struct Frame
+    {
+        uint32_t Tick = NoTick;
+        bool RemoteConfirmed = false;
+        std::array<GameInput, 2> Input = {};
+        std::vector<uint8_t> Snapshot; // State before the tick
+    };
+
+    Frame& frameAt(uint32_t tick);
+    void simulate(Frame& frame, bool saveSnapshot);
+
+    Simulation& mSimulation;
+    std::array<GameInput, 2>& mInput;
+    uint32_t mLocalPlayer;
+    uint32_t mRemotePlayer;
+    uint32_t mConfirmedTick = 0;
+    uint32_t mRollbackTick = NoTick; // Earliest tick that ran with a wrong prediction
+    bool mFailed = false;
+    GameInput mLastRemoteInput = {};
+    std::array<Frame, RollbackRingSize> mFrames;
+    RollbackStats mStats;
+};
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <stdint.h>
+
+// Independent streams of the simulation randomness, one per system drawing from it
+enum class SimStream : uint32_t
+{
+    Init,
+    Thrust,
+    Hits,
+    Destruction,
+};
+
+// Counter-based generator (Philox4x32-10): the output is a pure function of (seed, stream, substream, counter), so
+// streams can be split per system or per chunk without sharing state, and the whole generator is a few integers
+// that can be copied into a snapshot. Outputs come in blocks of four 32-bit values.
+class SimRandom final
+{
+public:
+    SimRandom(uint64_t seed = 0, uint32_t stream = 0, uint32_t substream = 0)
+    : mKey{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)}, mStream(stream), mSubstream(substream)
+    {}
+
+    // A generator that never overlaps with this one, for instance one per chunk of a parallel system.
+    // Only depends on the seed and ids, not on how far this generator already got.
+    SimRandom Split(uint32_t substream) const
+    {
+        SimRandom split = *this;
+        split.mSubstream = substream;
+        split.mCounter = 0;
+        split.mBufferIndex = BlockSize;
+        return split;
+    }
+
+    uint32_t NextUint()
+    {
+        if (mBufferIndex == BlockSize) {
+            mBuffer = generateBlock(mCounter++);
+            mBufferIndex = 0;
+        }
+        return mBuffer[mBufferIndex++];
+    }
+
+    // [0, 1)
+    float Uniform()
+    {
+        return toUnit(NextUint());
+    }
+
+    // [min, max)
+    float Uniform(float min, float max)
+    {
+        return min + Uniform() * (max - min);
+    }
+
+    // Standard normal, Box-Muller on one pair of outputs. The second value of the pair is dropped so the generator
+    // state stays plain integers.
+    float Normal()
+    {
+        const uint32_t first = NextUint();
+        const uint32_t second = NextUint();
+        return boxMuller(first, second)[0];
+    }
+
+    void FillUniform(float* out, size_t count)
+    {
+        size_t index = 0;
+        // Whole blocks straight from the counter, skipping the buffer
+        for (; mBufferIndex == BlockSize && index + BlockSize <= count; index += BlockSize) {
+            const std::array<uint32_t, BlockSize> block = generateBlock(mCounter++);
+            for (size_t lane = 0; lane < BlockSize; ++lane) {
+                out[index + lane] = toUnit(block[lane]);
+            }
+        }
+        for (; index < count; ++index) {
+            out[index] = Uniform();
+        }
+    }
+
+    // Uses both values of each Box-Muller pair
+    void FillNormal(float* out, size_t count)
+    {
+        size_t index = 0;
+        for (; mBufferIndex == BlockSize && index + BlockSize <= count; index += BlockSize) {
+            const std::array<uint32_t, BlockSize> block = generateBlock(mCounter++);
+            const std::array<float, 2> low = boxMuller(block[0], block[1]);
+            const std::array<float, 2> high = boxMuller(block[2], block[3]);
+            out[index] = low[0];
+            out[index + 1] = low[1];
+            out[index + 2] = high[0];
+            out[index + 3] = high[1];
+        }
+        for (; index < count; ++index) {
+            out[index] = Normal();
+        }
+    }
+
+private:
+    static constexpr uint32_t BlockSize = 4;
+    static constexpr uint32_t Rounds = 10;
+    static constexpr uint32_t MultiplierA = 0xD2511F53;
+    static constexpr uint32_t MultiplierB = 0xCD9E8D57;
+    static constexpr uint32_t WeylA = 0x9E3779B9;
+    static constexpr uint32_t WeylB = 0xBB67AE85;
+
+    std::array<uint32_t, BlockSize> generateBlock(uint64_t counter) const
+    {
+        std::array<uint32_t, BlockSize> block = {static_cast<uint32_t>(counter), static_cast<uint32_t>(counter >> 32),
+                                                 mStream, mSubstream};
+        std::array<uint32_t, 2> key = mKey;
+        for (uint32_t round = 0; round < Rounds; ++round) {
+            const uint64_t productA = static_cast<uint64_t>(MultiplierA) * block[0];
+            const uint64_t productB = static_cast<uint64_t>(MultiplierB) * block[2];
+            block = {static_cast<uint32_t>(productB >> 32) ^ block[1] ^ key[0], static_cast<uint32_t>(productB),
+                     static_cast<uint32_t>(productA >> 32) ^ block[3] ^ key[1], static_cast<uint32_t>(productA)};
+            key[0] += WeylA;
+            key[1] += WeylB;
+        }
+        return block;
+    }
+
+    // Top 24 bits, exactly representable as floats
+    static float toUnit(uint32_t value)
+    {
+        return static_cast<float>(value >> 8) * (1.f / 16777216.f);
+    }
+
+    static std::array<float, 2> boxMuller(uint32_t first, uint32_t second)
+    {
+        constexpr float TwoPi = 6.28318530718f;
+        // (0, 1] so the log stays finite
+        const float radius = std::sqrt(-2.f * std::log(static_cast<float>((first >> 8) + 1) * (1.f / 16777216.f)));
+        const float angle = TwoPi * toUnit(second);
+        return {radius * std::cos(angle), radius * std::sin(angle)};
+    }
+
+    std::array<uint32_t, 2> mKey;
+    uint32_t mStream;
+    uint32_t mSubstream;
+    uint64_t mCounter = 0;
+    std::array<uint32_t, BlockSize> mBuffer = {};
+    uint32_t mBufferIndex = BlockSize;
+};
@@ -0,0 +1,32 @@
+#include "SimSnapshot.h"
+#include <cstdio>
+
+bool WriteSnapshotFile(const char* path, const std::vector<uint8_t>& snapshot)
+{
+    FILE* file = std::fopen(path, "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    const bool written = std::fwrite(snapshot.data(), 1, snapshot.size(), file) == snapshot.size();
+    return std::fclose(file) == 0 && written;
+}
+
+bool ReadSnapshotFile(const char* path, std::vector<uint8_t>& snapshot)
+{
+    FILE* file = std::fopen(path, "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    SnapshotHeader header;
+    bool read = std::fread(&header, sizeof(SnapshotHeader), 1, file) == 1 && header.Magic == SnapshotMagic &&
+                header.Size >= sizeof(SnapshotHeader);
+    if (read) {
+        // The header tells the size, no need to seek
+        snapshot.resize(header.Size);
+        std::memcpy(snapshot.data(), &header, sizeof(SnapshotHeader));
+        const size_t rest = header.Size - sizeof(SnapshotHeader);
+        read = std::fread(snapshot.data() + sizeof(SnapshotHeader), 1, rest, file) == rest;
+    }
+    std::fclose(file);
+    return read;
+}
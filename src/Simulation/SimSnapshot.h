@@ -0,0 +1,158 @@
+#pragma once
+
+#include <array>
+#include <assert.h>
+#include <cstring>
+#include <stdint.h>
+#include <type_traits>
+#include <vector>
+
+constexpr uint32_t SnapshotMagic = 0x50414E53; // "SNAP"
+constexpr uint32_t SnapshotVersion = 1;
+constexpr size_t SnapshotAlignment = 16;
+constexpr uint32_t SnapshotMaxSections = 64;
+
+// Array of Count values of Stride bytes, starting Offset bytes into the snapshot
+struct SnapshotSection
+{
+    uint32_t Id;
+    uint32_t Count;
+    uint32_t Stride;
+    uint32_t Padding;
+    uint64_t Offset;
+};
+
+struct SnapshotHeader
+{
+    uint32_t Magic;
+    uint32_t Version;
+    uint32_t Frame;
+    uint32_t ReleasedEntity; // Head of the registry's list of released entities
+    uint32_t SectionCount;
+    uint32_t Padding;
+    uint64_t Size;
+    std::array<SnapshotSection, SnapshotMaxSections> Sections;
+};
+
+// Flat snapshot layout: the header with its section table, then the section arrays, each starting at a multiple of
+// SnapshotAlignment. Arrays are stored as they are in memory (raw host representation, like replay logs), so a
+// snapshot read or mapped from a file is used in place without parsing.
+class SnapshotWriter final
+{
+public:
+    // Starts over in buffer, its capacity is kept so saving every tick doesn't allocate
+    explicit SnapshotWriter(std::vector<uint8_t>& buffer)
+    : mBuffer(buffer)
+    {
+        mBuffer.clear();
+        mBuffer.resize(alignUp(sizeof(SnapshotHeader)));
+    }
+
+    // Adds a section of count values and returns where to put them, valid until the next Append
+    template <typename T>
+    T* Append(uint32_t id, size_t count)
+    {
+        static_assert(std::is_trivially_copyable_v<T> && !std::is_empty_v<T>);
+        assert(mHeader.SectionCount < SnapshotMaxSections);
+        const size_t offset = mBuffer.size();
+        mBuffer.resize(alignUp(offset + count * sizeof(T)));
+        mHeader.Sections[mHeader.SectionCount++] = {id, static_cast<uint32_t>(count), sizeof(T), 0, offset};
+        return reinterpret_cast<T*>(mBuffer.data() + offset);
+    }
+
+    template <typename T>
+    void Write(uint32_t id, const T* values, size_t count)
+    {
+        T* target = Append<T>(id, count);
+        if (count > 0) {
+            std::memcpy(target, values, count * sizeof(T));
+        }
+    }
+
+    // Writes the header, the buffer holds the whole snapshot afterwards
+    void Finish(uint32_t frame, uint32_t releasedEntity)
+    {
+        mHeader.Magic = SnapshotMagic;
+        mHeader.Version = SnapshotVersion;
+        mHeader.Frame = frame;
+        mHeader.ReleasedEntity = releasedEntity;
+        mHeader.Size = mBuffer.size();
+        std::memcpy(mBuffer.data(), &mHeader, sizeof(SnapshotHeader));
+    }
+
+private:
+    static size_t alignUp(size_t size)
+    {
+        return (size + SnapshotAlignment - 1) / SnapshotAlignment * SnapshotAlignment;
+    }
+
+    std::vector<uint8_t>& mBuffer;
+    SnapshotHeader mHeader = {};
+};
+
+class SnapshotReader final
+{
+public:
+    // False when data isn't a well formed snapshot of this version. data must stay alive while reading and be
+    // SnapshotAlignment aligned, as vector storage and mapped files are.
+    bool Open(const uint8_t* data, size_t size)
+    {
+        mData = nullptr;
+        if (size < sizeof(SnapshotHeader) || reinterpret_cast<uintptr_t>(data) % SnapshotAlignment != 0) {
+            return false;
+        }
+        std::memcpy(&mHeader, data, sizeof(SnapshotHeader));
+        if (mHeader.Magic != SnapshotMagic || mHeader.Version != SnapshotVersion || mHeader.Size != size ||
+            mHeader.SectionCount > SnapshotMaxSections) {
+            return false;
+        }
+        for (uint32_t index = 0; index < mHeader.SectionCount; ++index) {
+            const SnapshotSection& section = mHeader.Sections[index];
+            if (section.Offset % SnapshotAlignment != 0 || section.Offset > size ||
+                static_cast<uint64_t>(section.Count) * section.Stride > size - section.Offset) {
+                return false;
+            }
+        }
+        mData = data;
+        return true;
+    }
+
+    uint32_t Frame() const
+    {
+        return mHeader.Frame;
+    }
+
+    uint32_t ReleasedEntity() const
+    {
+        return mHeader.ReleasedEntity;
+    }
+
+    // A missing section reads as empty. False when the section was saved with another size of T.
+    template <typename T>
+    bool Read(uint32_t id, const T*& values, size_t& count) const
+    {
+        static_assert(std::is_trivially_copyable_v<T> && !std::is_empty_v<T>);
+        values = nullptr;
+        count = 0;
+        for (uint32_t index = 0; index < mHeader.SectionCount; ++index) {
+            const SnapshotSection& section = mHeader.Sections[index];
+            if (section.Id == id) {
+                if (section.Stride != sizeof(T)) {
+                    return false;
+                }
+                values = reinterpret_cast<const T*>(mData + section.Offset);
+                count = section.Count;
+                return true;
+            }
+        }
+        return true;
+    }
+
+private:
+    const uint8_t* mData = nullptr;
+    SnapshotHeader mHeader = {};
+};
+
+bool WriteSnapshotFile(const char* path, const std::vector<uint8_t>& snapshot);
+// Reads the whole file in one allocation, ready for Simulation::LoadSnapshot
+bool ReadSnapshotFile(const char* path, std::vector<uint8_t>& snapshot);
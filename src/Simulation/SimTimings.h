@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <stdint.h>
+
+enum class SimPhase : uint32_t
+{
+    Destroy,
+    Respawn,
+    Explosions,
+    Angular,
+    Players,
+    Thrust,
+    BulletLifetime,
+    ParticleLifetime,
+    ParticleIntegrate,
+    Dynamics,
+    Wrap,
+    Partition,
+    FlushInsertions,
+    Collide,
+    ExplosionPush,
+    ParticleCollision,
+    BulletCollision,
+    PostCollision,
+    Hits,
+    Shoot,
+    Destruction,
+    Count
+};
+
+struct SimTimings
+{
+    using Clock = std::chrono::steady_clock;
+
+    std::array<Clock::duration, static_cast<size_t>(SimPhase::Count)> PhaseTimes = {};
+
+    void Reset()
+    {
+        PhaseTimes.fill(Clock::duration::zero());
+    }
+
+    static const char* PhaseName(SimPhase phase)
+    {
+        constexpr std::array<const char*, static_cast<size_t>(SimPhase::Count)> Names = {
+        "Destroy",         "Respawn",          "Explosions",        "Angular",       "Players",
+        "Thrust",          "BulletLifetime",   "ParticleLifetime",  "ParticleIntegrate", "Dynamics",
+        "Wrap",            "Partition",        "FlushInsertions",   "Collide",       "ExplosionPush",
+        "ParticleCollision", "BulletCollision", "PostCollision",    "Hits",          "Shoot",
+        "Destruction"};
+        return Names[static_cast<size_t>(phase)];
+    }
+};
+
+// Accumulates the scope duration into the given phase, does nothing when no timings are attached
+class ScopedSimPhase final
+{
+public:
+    ScopedSimPhase(SimTimings* timings, SimPhase phase) : mTimings(timings), mPhase(phase)
+    {
+        if (mTimings != nullptr) {
+            mStart = SimTimings::Clock::now();
+        }
+    }
+
+    ~ScopedSimPhase()
+    {
+        if (mTimings != nullptr) {
+            mTimings->PhaseTimes[static_cast<size_t>(mPhase)] += SimTimings::Clock::now() - mStart;
+        }
+    }
+
+private:
+    SimTimings* mTimings;
+    SimPhase mPhase;
+    SimTimings::Clock::time_point mStart;
+};
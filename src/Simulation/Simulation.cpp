@@ -2,22 +2,36 @@
 #include <tracy/Tracy.hpp>
 
 #include "Components.h"
+#include "ParallelForEach.h"
+#include "ParticleKernels.h"
+#include "SimSnapshot.h"
+#include "StateHasher.h"
+#include <atomic>
 #include <raymath.h>
+#include <utility>
 
-static std::uniform_real_distribution<float> UniformDistribution(0.f, 1.f);
-static std::uniform_real_distribution<float> DirectionDistribution(0.f, 2.f * PI);
+static constexpr float DeltaTime = SimTimeData::DeltaTime;
+
+static size_t SimWorkerThreads()
+{
+    // Leave room for the present thread and the render pool
+    return std::max(1u, std::thread::hardware_concurrency() / 2);
+}
 
 Simulation::Simulation(const SimDependencies& dependencies)
 : mRegistry(dependencies.GetDependency<entt::registry>()),
-  mGameInput(dependencies.GetDependency<std::remove_reference<decltype(mGameInput)>::type>())
-{}
+  mGameInput(dependencies.GetDependency<std::remove_reference<decltype(mGameInput)>::type>()),
+  mThreadPool(SimWorkerThreads())
+{
+    BuildSystems();
+}
 
-static void MakeAsteroid(entt::registry& registry, float radius, const Vector3 position, const Vector3 velocity)
+static void MakeAsteroid(SimCommandBuffer& commands, float radius, const Vector3 position, const Vector3 velocity)
 {
-    entt::entity asteroid = registry.create();
-    registry.emplace<AsteroidComponent>(asteroid, radius);
-    registry.emplace<PositionComponent>(asteroid, position);
-    registry.emplace<VelocityComponent>(asteroid, velocity);
+    DeferredEntity asteroid = commands.Create();
+    commands.Emplace(asteroid, AsteroidComponent{radius});
+    commands.Emplace(asteroid, PositionComponent{position});
+    commands.Emplace(asteroid, VelocityComponent{velocity});
 }
 
 static Vector3 DefaultPlayerPosition(uint32_t inputID)
@@ -40,30 +54,41 @@ static void SpawnSpaceship(entt::registry& registry, const Vector3& position, ui
     registry.emplace<GunComponent>(player, 0.f, 0u);
 }
 
-void Simulation::Init(uint32_t players)
+void Simulation::Init(uint32_t players, uint32_t asteroids)
 {
     mRegistry.clear();
-    mRegistry.reserve(64000);
+    mRegistry.reserve(4096);
+    mParticles.Clear();
+    mParticles.Reserve(64000);
 
     for (uint32_t player = 0; player < players; ++player) {
         SpawnSpaceship(mRegistry, DefaultPlayerPosition(player), player);
     }
 
-    std::uniform_real_distribution<float> xDistribution(0.f, SpaceData::LengthX);
-    std::uniform_real_distribution<float> zDistribution(0.f, SpaceData::LengthZ);
-    std::uniform_real_distribution<float> speedDistribution(0.f, 2.f * SpaceData::AsteroidDriftSpeed);
-    std::uniform_real_distribution<float> radiusDistribution(SpaceData::MinAsteroidRadius,
-                                                             SpaceData::MaxAsteroidRadius);
-    for (int i = 0; i < SpaceData::AsteroidsCount; ++i) {
-        float angle = DirectionDistribution(mRandomGenerator);
-        float speed = speedDistribution(mRandomGenerator);
-        MakeAsteroid(mRegistry, radiusDistribution(mRandomGenerator),
-                     {xDistribution(mRandomGenerator), 0.f, zDistribution(mRandomGenerator)},
-                     {cos(angle) * speed, 0.f, sin(angle) * speed});
+    mInitRandom = SimRandom(Settings.Seed, static_cast<uint32_t>(SimStream::Init));
+    mThrustRandom = SimRandom(Settings.Seed, static_cast<uint32_t>(SimStream::Thrust));
+    mHitRandom = SimRandom(Settings.Seed, static_cast<uint32_t>(SimStream::Hits));
+    mDestructionRandom = SimRandom(Settings.Seed, static_cast<uint32_t>(SimStream::Destruction));
+
+    // Draws are named so their order doesn't depend on how the compiler evaluates arguments
+    for (uint32_t i = 0; i < asteroids; ++i) {
+        const float angle = mInitRandom.Uniform(0.f, 2.f * PI);
+        const float speed = mInitRandom.Uniform(0.f, 2.f * SpaceData::AsteroidDriftSpeed);
+        const float radius = mInitRandom.Uniform(SpaceData::MinAsteroidRadius, SpaceData::MaxAsteroidRadius);
+        const float x = mInitRandom.Uniform(0.f, SpaceData::LengthX);
+        const float z = mInitRandom.Uniform(0.f, SpaceData::LengthZ);
+        MakeAsteroid(mCommands, radius, {x, 0.f, z}, {cos(angle) * speed, 0.f, sin(angle) * speed});
     }
+    mCommands.Playback(mRegistry);
 
+    ResetPartition();
+}
+
+void Simulation::ResetPartition()
+{
     mSpatialPartition.InitArea({SpaceData::LengthX, SpaceData::LengthZ}, SpaceData::CellCountX,
                                SpaceData::CellCountZ);
+    mSpatialPartition.Reset();
 }
 
 static Vector3 HorizontalOrthogonal(const Vector3& vector)
@@ -78,101 +103,150 @@ static void ProcessInput(entt::registry& registry, const std::array<GameInput, 2
     }
 }
 
-void Simulation::MakeExplosion(const Vector3& position, const Vector3& velocity, float radius)
+void Simulation::MakeExplosion(SimCommandBuffer& commands,
+                               SimRandom& random,
+                               const Vector3& position,
+                               const Vector3& velocity,
+                               float radius)
 {
-    auto explosion = mRegistry.create();
-    mRegistry.emplace<PositionComponent>(explosion, position);
-    mRegistry.emplace<VelocityComponent>(explosion, velocity);
-    mRegistry.emplace<ExplosionComponent>(explosion, GameTime, 0.f, radius);
-    for (size_t i = 0; i < 500; ++i) {
-        auto particle = mRegistry.create();
-        std::normal_distribution normal(0.f, 1.f);
-        float x = normal(mRandomGenerator);
-        float y = normal(mRandomGenerator);
-        float z = normal(mRandomGenerator);
-        const Vector3 radial = Vector3Normalize({x, y, z});
-        mRegistry.emplace<PositionComponent>(particle, Vector3Add(position, Vector3Scale(radial, 0.1f)));
-        mRegistry.emplace<VelocityComponent>(particle,
-                                             Vector3Add(velocity, Vector3Scale(radial, ExplosionData::ParticleForce)));
-        mRegistry.emplace<ParticleComponent>(
-        particle, (UniformDistribution(mRandomGenerator) + UniformDistribution(mRandomGenerator)) * 14.f, GOLD);
-        mRegistry.emplace<ParticleDragComponent>(particle);
+    DeferredEntity explosion = commands.Create();
+    commands.Emplace(explosion, PositionComponent{position});
+    commands.Emplace(explosion, VelocityComponent{velocity});
+    commands.Emplace(explosion, ExplosionComponent{GameTime, 0.f, radius});
+    constexpr size_t ExplosionParticles = 500;
+    // Random inputs are drawn in bulk straight into the new slots, then one vectorized pass builds the burst
+    const size_t first = mParticles.Grow(ExplosionParticles, GOLD);
+    const size_t last = first + ExplosionParticles;
+    random.FillNormal(mParticles.VelocitiesX.data() + first, ExplosionParticles);
+    random.FillNormal(mParticles.VelocitiesY.data() + first, ExplosionParticles);
+    random.FillNormal(mParticles.VelocitiesZ.data() + first, ExplosionParticles);
+    random.FillUniform(mParticles.LifeTimes.data() + first, ExplosionParticles);
+    for (size_t index = first; index < last; ++index) {
+        mParticles.LifeTimes[index] = (mParticles.LifeTimes[index] + random.Uniform()) * 14.f;
     }
+    ParticleKernels::RadialBurst(mParticles, first, last, position, velocity, 0.1f, ExplosionData::ParticleForce);
 };
 
-template <typename TComponent>
-static void CopyStorage(const entt::registry& source, entt::registry& target)
-{
-    auto view = source.view<TComponent>();
-    if constexpr (std::is_empty<TComponent>()) {
-        for (auto entity : view) {
-            target.emplace<TComponent>(entity);
-        }
-    } else {
-        auto process = [&](auto entity, const auto& component) {
-            target.emplace<TComponent>(entity, component);
-        };
-        view.each(process);
-    }
-}
-
-void Simulation::WriteRenderState(entt::registry& target) const
+void Simulation::WriteRenderState(RenderSnapshot& target) const
 {
     ZoneScopedN("WriteRenderState");
-    assert(target.empty());
-    target.reserve(mRegistry.size());
-    target.assign(mRegistry.data(), mRegistry.data() + mRegistry.size(), mRegistry.released());
+    target.Clear();
+    target.Frame = mFrame;
     {
-        ZoneScopedN("Positions");
-        CopyStorage<PositionComponent>(mRegistry, target);
+        ZoneScopedN("Spawners");
+        for (auto [respawner, respawn, position] : mRegistry.view<RespawnComponent, PositionComponent>().each()) {
+            if (respawn.TimeLeft <= 0.f) {
+                target.Respawners.push_back({position.Position, respawn.InputId});
+            }
+        }
     }
     {
-        ZoneScopedN("Orientations");
-        CopyStorage<OrientationComponent>(mRegistry, target);
+        ZoneScopedN("Spaceships");
+        auto spaceshipView = mRegistry.view<PositionComponent, OrientationComponent, SpaceshipInputComponent>();
+        for (auto [spaceship, position, orientation, input] : spaceshipView.each()) {
+            target.Spaceships.push_back({position.Position, orientation.Rotation, input.InputId});
+        }
     }
     {
         ZoneScopedN("Explosions");
-        CopyStorage<ExplosionComponent>(mRegistry, target);
+        for (auto [explosion, explosionComponent, position] :
+             mRegistry.view<ExplosionComponent, PositionComponent>().each()) {
+            target.Explosions.push_back(
+            {position.Position, explosionComponent.CurrentRadius, explosionComponent.TerminalRadius});
+        }
     }
     {
-        ZoneScopedN("Particles");
-        CopyStorage<ParticleComponent>(mRegistry, target);
+        ZoneScopedN("Asteroids");
+        // Indexed through the asteroid storage, every asteroid has a position
+        const auto& asteroidStorage = mRegistry.storage<AsteroidComponent>();
+        const auto& positionStorage = mRegistry.storage<PositionComponent>();
+        const entt::entity* asteroids = asteroidStorage.data();
+        auto cellOf = [&](size_t index) {
+            const Vector3& position = positionStorage.get(asteroids[index]).Position;
+            return RenderGrid::CellOf(position.x, position.z);
+        };
+        auto place = [&](size_t index, uint32_t slot) {
+            target.Asteroids[slot] = {positionStorage.get(asteroids[index]).Position,
+                                      asteroidStorage.get(asteroids[index]).Radius};
+        };
+        target.Asteroids.resize(asteroidStorage.size());
+        RenderGrid::SortIntoCells(asteroidStorage.size(), target.AsteroidCellStarts, cellOf, place);
     }
     {
         ZoneScopedN("Bullets");
-        CopyStorage<BulletComponent>(mRegistry, target);
-    }
-    {
-        ZoneScopedN("Asteroids");
-        CopyStorage<AsteroidComponent>(mRegistry, target);
+        for (auto [bullet, particle, position] :
+             mRegistry.view<BulletComponent, ParticleComponent, PositionComponent>().each()) {
+            target.Bullets.push_back({position.Position, particle.Color});
+        }
     }
     {
-        ZoneScopedN("Spaceships");
-        CopyStorage<SpaceshipInputComponent>(mRegistry, target);
+        ZoneScopedN("Particles");
+        auto cellOf = [&](size_t index) {
+            return RenderGrid::CellOf(mParticles.PositionsX[index], mParticles.PositionsZ[index]);
+        };
+        auto place = [&](size_t index, uint32_t slot) {
+            target.ParticlesX[slot] = mParticles.PositionsX[index];
+            target.ParticlesY[slot] = mParticles.PositionsY[index];
+            target.ParticlesZ[slot] = mParticles.PositionsZ[index];
+            target.ParticleColors[slot] = mParticles.Colors[index];
+        };
+        target.ParticlesX.resize(mParticles.Size());
+        target.ParticlesY.resize(mParticles.Size());
+        target.ParticlesZ.resize(mParticles.Size());
+        target.ParticleColors.resize(mParticles.Size());
+        RenderGrid::SortIntoCells(mParticles.Size(), target.ParticleCellStarts, cellOf, place);
     }
-    {
-        ZoneScopedN("Spawners");
-        CopyStorage<RespawnComponent>(mRegistry, target);
+}
+
+static float FindCoordinateGap(float coord1, float coord2, float mod)
+{
+    float coordGap = coord2 - coord1;
+    if (abs(coordGap + mod) < abs(coordGap)) {
+        return coordGap + mod;
+    } else if (abs(coordGap - mod) < abs(coordGap)) {
+        return coordGap - mod;
     }
+    return coordGap;
 }
 
-void Simulation::Simulate()
+static Vector3 FindVectorGap(const Vector3& from, const Vector3& to)
 {
-    constexpr float deltaTime = SimTimeData::DeltaTime;
+    const float x1 = from.x;
+    const float x2 = to.x;
+    const float gapX = FindCoordinateGap(x1, x2, SpaceData::LengthX);
+
+    const float z1 = from.z;
+    const float z2 = to.z;
+    const float gapZ = FindCoordinateGap(z1, z2, SpaceData::LengthZ);
 
+    return Vector3{gapX, to.y - from.y, gapZ};
+}
+
+void Simulation::DestroyEntities()
+{
+    ZoneScoped;
+    ScopedSimPhase phase(mTimings, SimPhase::Destroy);
     auto destroyView = mRegistry.view<DestroyComponent>();
+    for (auto [entity, proxy] : mRegistry.view<DestroyComponent, PartitionProxyComponent>().each()) {
+        mSpatialPartition.Remove(proxy.Handle);
+    }
     mRegistry.destroy(destroyView.begin(), destroyView.end());
+}
 
+void Simulation::UpdateRespawners()
+{
+    ZoneScoped;
+    ScopedSimPhase phase(mTimings, SimPhase::Respawn);
     for (auto respawner : mRegistry.view<RespawnComponent, PositionComponent>()) {
         RespawnComponent& respawn = mRegistry.get<RespawnComponent>(respawner);
-        respawn.TimeLeft -= deltaTime;
+        respawn.TimeLeft -= DeltaTime;
         if (respawn.TimeLeft > 0.f) {
             continue;
         }
         Vector3& position = mRegistry.get<PositionComponent>(respawner).Position;
         if (!respawn.Primed && !mGameInput[respawn.InputId].Fire) {
-            position.x += mGameInput[respawn.InputId].Left * RespawnData::MarkerMoveSpeed * deltaTime;
-            position.z += mGameInput[respawn.InputId].Forward * RespawnData::MarkerMoveSpeed * deltaTime;
+            position.x += mGameInput[respawn.InputId].Left * RespawnData::MarkerMoveSpeed * DeltaTime;
+            position.z += mGameInput[respawn.InputId].Forward * RespawnData::MarkerMoveSpeed * DeltaTime;
             continue;
         }
         if (!respawn.Primed && mGameInput[respawn.InputId].Fire) {
@@ -184,7 +258,12 @@ void Simulation::Simulate()
             mRegistry.destroy(respawner);
         }
     }
+}
 
+void Simulation::UpdateExplosions()
+{
+    ZoneScoped;
+    ScopedSimPhase phase(mTimings, SimPhase::Explosions);
     auto explosionView = mRegistry.view<ExplosionComponent, PositionComponent>();
     auto explosionProcess = [&](auto explosion, ExplosionComponent& explosionComponent,
                                 const PositionComponent& positionComponent) {
@@ -196,24 +275,37 @@ void Simulation::Simulate()
         cbrt(std::clamp(elapsedTime / ExplosionData::Time, 0.f, 1.f)) * explosionComponent.TerminalRadius;
     };
     explosionView.each(explosionProcess);
+}
 
+void Simulation::UpdateAngular()
+{
+    ZoneScoped;
+    ScopedSimPhase phase(mTimings, SimPhase::Angular);
     auto angularView = mRegistry.view<AngularComponent, OrientationComponent>();
     auto angularProcess = [](entt::entity entity, AngularComponent& angularComponent,
                              OrientationComponent& orientationComponent) {
         if (FloatEquals(angularComponent.YawMomentum, 0.f)) {
             return;
         }
-        Quaternion yawQuaternion = QuaternionFromAxisAngle(Up3, angularComponent.YawMomentum * deltaTime);
+        Quaternion yawQuaternion = QuaternionFromAxisAngle(Up3, angularComponent.YawMomentum * DeltaTime);
         orientationComponent.Rotation = QuaternionMultiply(yawQuaternion, orientationComponent.Rotation);
         angularComponent.YawMomentum *= SpaceshipData::AngularMomentumDrag;
     };
-    angularView.each(angularProcess);
+    ParallelForEach(mThreadPool, mAngularTasks, angularView, angularProcess);
+}
 
+void Simulation::UpdatePlayers()
+{
+    ZoneScoped;
+    ScopedSimPhase phase(mTimings, SimPhase::Players);
     auto playerView =
     mRegistry.view<VelocityComponent, OrientationComponent, SteerComponent, SpaceshipInputComponent, ThrustComponent>();
-    auto playerProcess = [this](entt::entity entity, VelocityComponent& velocityComponent,
-                                OrientationComponent& orientationComponent, SteerComponent& steerComponent,
-                                const SpaceshipInputComponent& inputComponent, ThrustComponent& thrustComponent) {
+    auto& maneuverStorage = mRegistry.storage<SpecialManeuver>();
+    auto playerProcess = [&maneuverStorage](SimCommandBuffer& commands, entt::entity entity,
+                                            VelocityComponent& velocityComponent,
+                                            OrientationComponent& orientationComponent, SteerComponent& steerComponent,
+                                            const SpaceshipInputComponent& inputComponent,
+                                            ThrustComponent& thrustComponent) {
         const GameInput& input = inputComponent.Input;
         Vector3 inputTarget = {input.Left, 0.f, input.Forward};
         float inputLength = Vector3Length(inputTarget);
@@ -233,38 +325,40 @@ void Simulation::Simulate()
 
         thrustComponent.Thrust = thrust;
 
-        Vector3 acceleration = Vector3Scale(forward, deltaTime * thrustComponent.Thrust);
+        Vector3 acceleration = Vector3Scale(forward, DeltaTime * thrustComponent.Thrust);
 
         Vector3 secondaryInputTarget = {input.SecondaryLeft, 0.f, input.SecondaryForward};
         float extraRoll = 0.f;
-        auto* maneuver = mRegistry.try_get<SpecialManeuver>(entity);
+        // Only this entity's maneuver is touched, adding or removing one goes through the chunk's commands
+        auto* maneuver = maneuverStorage.contains(entity) ? &maneuverStorage.get(entity) : nullptr;
         if (!Vector3Equals(secondaryInputTarget, Vector3Zero())) {
             Vector3 horizontalLeft = HorizontalOrthogonal(forward);
             float secondarySideThrust = Vector3DotProduct(horizontalLeft, secondaryInputTarget);
             acceleration =
-            Vector3Add(acceleration, Vector3Scale(horizontalLeft, deltaTime * secondarySideThrust * 30.f));
-            if (maneuver == nullptr) {
-                maneuver = &mRegistry.emplace<SpecialManeuver>(entity);
+            Vector3Add(acceleration, Vector3Scale(horizontalLeft, DeltaTime * secondarySideThrust * 30.f));
+            SpecialManeuver newManeuver = {};
+            SpecialManeuver& state = (maneuver != nullptr) ? *maneuver : newManeuver;
+            state.SideMomentum = secondarySideThrust * 10.f;
+            state.SideProgress += DeltaTime * state.SideMomentum;
+            while (state.SideProgress > PI) {
+                state.SideProgress -= 2.f * PI;
             }
-            maneuver->SideMomentum = secondarySideThrust * 10.f;
-            maneuver->SideProgress += deltaTime * maneuver->SideMomentum;
-            while (maneuver->SideProgress > PI) {
-                maneuver->SideProgress -= 2.f * PI;
+            while (state.SideProgress < -PI) {
+                state.SideProgress += 2.f * PI;
             }
-            while (maneuver->SideProgress < -PI) {
-                maneuver->SideProgress += 2.f * PI;
+            extraRoll = state.SideProgress;
+            if (maneuver == nullptr) {
+                commands.Emplace(entity, newManeuver);
             }
-            extraRoll = maneuver->SideProgress;
         } else if (maneuver != nullptr) {
             maneuver->SideMomentum *= SpaceshipData::AngularMomentumDrag;
             maneuver->SideProgress *= SpaceshipData::AngularMomentumDrag;
             if (!FloatEquals(maneuver->SideMomentum, 0.f)) {
-                maneuver->SideProgress += deltaTime * maneuver->SideMomentum;
+                maneuver->SideProgress += DeltaTime * maneuver->SideMomentum;
                 extraRoll = maneuver->SideProgress;
             } else {
                 steerComponent.Steer += maneuver->SideProgress;
-                mRegistry.erase<SpecialManeuver>(entity);
-                maneuver = nullptr;
+                commands.Erase<SpecialManeuver>(entity);
             }
         }
 
@@ -284,7 +378,7 @@ void Simulation::Simulate()
         steer *= steerSign;
 
         float turnCos = Vector3DotProduct(forward, inputDirection);
-        static const float minCos = cosf(std::max(SpaceshipData::Yaw, SpaceshipData::Pitch) * deltaTime);
+        static const float minCos = cosf(std::max(SpaceshipData::Yaw, SpaceshipData::Pitch) * DeltaTime);
         bool turn = minCos > turnCos;
 
         float turnDistance = std::clamp(1.f - turnCos, 0.f, 2.f);
@@ -297,20 +391,20 @@ void Simulation::Simulate()
             steeringSign = -1.f;
         }
         if (!turn) {
-            steer -= SpaceshipData::NegativeRoll * deltaTime;
+            steer -= SpaceshipData::NegativeRoll * DeltaTime;
             steer = std::max(steer, 0.f);
         } else {
             if (steeringSign != steerSign) {
                 if (PI - targetSteer < steer) {
                     specialRoll = true;
-                    steer += SpaceshipData::SpecialRoll * deltaTime;
+                    steer += SpaceshipData::SpecialRoll * DeltaTime;
                 } else {
-                    steer -= SpaceshipData::NegativeRoll * deltaTime;
+                    steer -= SpaceshipData::NegativeRoll * DeltaTime;
                 }
             } else if (steer > targetSteer) {
-                steer -= SpaceshipData::NegativeRoll * deltaTime;
+                steer -= SpaceshipData::NegativeRoll * DeltaTime;
             } else {
-                steer += SpaceshipData::Roll * deltaTime;
+                steer += SpaceshipData::Roll * DeltaTime;
                 steer = std::min(steer, targetSteer);
             }
         }
@@ -351,7 +445,7 @@ void Simulation::Simulate()
                 yawQuaternion = QuaternionFromVector3ToVector3(Forward3, forward);
             }
 
-            Quaternion turningQuaternion = QuaternionFromAxisAngle(Up3, turnAbility * deltaTime);
+            Quaternion turningQuaternion = QuaternionFromAxisAngle(Up3, turnAbility * DeltaTime);
 
             resultingQuaternion = QuaternionMultiply(yawQuaternion, rollQuaternion);
             resultingQuaternion = QuaternionMultiply(turningQuaternion, resultingQuaternion);
@@ -370,8 +464,17 @@ void Simulation::Simulate()
         }
         orientationComponent.Rotation = resultingQuaternion;
     };
-    playerView.each(playerProcess);
+    const size_t chunks =
+    ParallelForEachDeferred(mThreadPool, mPlayerTasks, playerView, mPlayerCommands, playerProcess);
+    for (size_t chunk = 0; chunk < chunks; ++chunk) {
+        mPlayerCommands[chunk].Playback(mRegistry);
+    }
+}
 
+void Simulation::EmitThrustParticles()
+{
+    ZoneScoped;
+    ScopedSimPhase phase(mTimings, SimPhase::Thrust);
     auto thrustView =
     mRegistry.view<ThrustComponent, PositionComponent, VelocityComponent, OrientationComponent, SpaceshipInputComponent>();
     auto thrustParticleProcess = [this](ThrustComponent& thrustComponent, const PositionComponent& positionComponent,
@@ -389,57 +492,85 @@ void Simulation::Simulate()
         Vector3 baseVelocity = velocityComponent.Velocity;
         Vector3 back = Vector3RotateByQuaternion(Back3, orientationComponent.Rotation);
         baseVelocity =
-        Vector3Add(baseVelocity, Vector3Scale(back, thrustComponent.Thrust * ThrustModule * deltaTime));
+        Vector3Add(baseVelocity, Vector3Scale(back, thrustComponent.Thrust * ThrustModule * DeltaTime));
 
         constexpr std::array<Color, 2> ThrustColors = {PINK, SKYBLUE};
 
+        const Vector3 particlePosition = Vector3Add(positionComponent.Position, Vector3Scale(back, Offset));
         while (particles-- > 0) {
-            entt::entity particleEntity = mRegistry.create();
-            mRegistry.emplace<ParticleDragComponent>(particleEntity);
-            mRegistry.emplace<PositionComponent>(particleEntity, Vector3Add(positionComponent.Position,
-                                                                            Vector3Scale(back, Offset)));
-            std::normal_distribution normal(0.f, 1.f);
-            float randX = normal(mRandomGenerator);
-            float randY = normal(mRandomGenerator);
-            float randZ = normal(mRandomGenerator);
+            float randX = mThrustRandom.Normal();
+            float randY = mThrustRandom.Normal();
+            float randZ = mThrustRandom.Normal();
             Vector3 randomVelocity = Vector3Scale({randX, randY, randZ}, RandomModule);
-            mRegistry.emplace<VelocityComponent>(particleEntity, Vector3Add(baseVelocity, randomVelocity));
-            float lifetime =
-            14.f * (UniformDistribution(mRandomGenerator) + UniformDistribution(mRandomGenerator));
-            mRegistry.emplace<ParticleComponent>(particleEntity, lifetime,
-                                                 ThrustColors[inputComponent.InputId]);
+            float lifetime = 14.f * (mThrustRandom.Uniform() + mThrustRandom.Uniform());
+            mParticles.Add(particlePosition, Vector3Add(baseVelocity, randomVelocity), lifetime,
+                           ThrustColors[inputComponent.InputId]);
         }
     };
     thrustView.each(thrustParticleProcess);
+}
 
+void Simulation::UpdateBulletLifetimes()
+{
+    ZoneScoped;
+    ScopedSimPhase phase(mTimings, SimPhase::BulletLifetime);
     auto particleView = mRegistry.view<ParticleComponent>();
-    auto particleLifetimeProcess = [this](entt::entity particle, ParticleComponent& particleComponent) {
+    auto particleLifetimeProcess = [](SimCommandBuffer& commands, entt::entity particle,
+                                      ParticleComponent& particleComponent) {
         if (particleComponent.LifeTime <= 0.f) {
-            mRegistry.emplace<DestroyComponent>(particle);
+            commands.Emplace<DestroyComponent>(particle);
             return;
         }
-        particleComponent.LifeTime -= deltaTime;
+        particleComponent.LifeTime -= DeltaTime;
     };
-    particleView.each(particleLifetimeProcess);
+    const size_t chunks = ParallelForEachDeferred(mThreadPool, mBulletLifetimeTasks, particleView,
+                                                  mBulletLifetimeCommands, particleLifetimeProcess);
+    for (size_t chunk = 0; chunk < chunks; ++chunk) {
+        mBulletLifetimeCommands[chunk].Playback(mRegistry);
+    }
+}
 
-    auto particleDragView = mRegistry.view<ParticleDragComponent, VelocityComponent>();
-    auto particleDragProcess = [](VelocityComponent& velocityComponent) {
-        float speed = Vector3Length(velocityComponent.Velocity);
-        if (!FloatEquals(speed, 0.f)) {
-            float drag = speed * ParticleData::LinearDrag + speed * speed * ParticleData::QuadraticDrag;
-            velocityComponent.Velocity =
-            Vector3Add(velocityComponent.Velocity, Vector3Scale(velocityComponent.Velocity, -drag / speed));
+void Simulation::UpdateParticleLifetimes()
+{
+    ZoneScoped;
+    ScopedSimPhase phase(mTimings, SimPhase::ParticleLifetime);
+    // Walking backwards so swapped in particles were already visited
+    for (size_t index = mParticles.Size(); index-- > 0;) {
+        if (mParticles.LifeTimes[index] <= 0.f) {
+            mParticles.SwapRemove(index);
+        } else {
+            mParticles.LifeTimes[index] -= DeltaTime;
         }
+    }
+}
+
+void Simulation::IntegrateParticles()
+{
+    ZoneScoped;
+    ScopedSimPhase phase(mTimings, SimPhase::ParticleIntegrate);
+    constexpr size_t ChunkSize = 16384;
+    auto particleIntegrateChunk = [this](size_t chunkIndex, size_t first, size_t last) {
+        ParticleKernels::DragIntegrateWrap(mParticles, first, last, DeltaTime);
     };
-    particleDragView.each(particleDragProcess);
+    RunChunks(mThreadPool, mIntegrateTasks, mParticles.Size(), ChunkSize, particleIntegrateChunk);
+}
 
+void Simulation::IntegrateDynamics()
+{
+    ZoneScoped;
+    ScopedSimPhase phase(mTimings, SimPhase::Dynamics);
     auto dynamicView = mRegistry.view<PositionComponent, VelocityComponent>();
     auto dynamicProcess = [](PositionComponent& positionComponent, const VelocityComponent& velocityComponent) {
         positionComponent.Position =
-        Vector3Add(positionComponent.Position, Vector3Scale(velocityComponent.Velocity, deltaTime));
+        Vector3Add(positionComponent.Position, Vector3Scale(velocityComponent.Velocity, DeltaTime));
     };
-    dynamicView.each(dynamicProcess);
+    ParallelForEach(mThreadPool, mDynamicsTasks, dynamicView, dynamicProcess);
+}
 
+void Simulation::WrapPositions()
+{
+    ZoneScoped;
+    ScopedSimPhase phase(mTimings, SimPhase::Wrap);
     auto wrapView = mRegistry.view<PositionComponent>();
     auto wrapProcess = [](PositionComponent& positionComponent) {
         const float x = positionComponent.Position.x;
@@ -455,173 +586,255 @@ void Simulation::Simulate()
             positionComponent.Position.z -= SpaceData::LengthZ;
         }
     };
-    wrapView.each(wrapProcess);
-
-    mSpatialPartition.Clear();
-
-    {
-        ZoneScopedN("Partition");
-        auto asteroidView = mRegistry.view<PositionComponent, AsteroidComponent>();
-        auto partitionAsteroids = [this](entt::entity asteroid, const PositionComponent& positionComponent,
-                                         const AsteroidComponent& asteroidComponent) {
-            const float radius = asteroidComponent.Radius;
-            const Vector2 flatPosition = {positionComponent.Position.x, positionComponent.Position.z};
-            const Vector2 min = {flatPosition.x - radius, flatPosition.y - radius};
-            const Vector2 max = {flatPosition.x + radius, flatPosition.y + radius};
-            mSpatialPartition.InsertDeferred({asteroid, radius}, min, max);
-        };
-        asteroidView.each(partitionAsteroids);
+    ParallelForEach(mThreadPool, mWrapTasks, wrapView, wrapProcess);
+}
 
-        auto playerCollisionView = mRegistry.view<PositionComponent, SpaceshipInputComponent>();
-        for (auto spaceship : playerCollisionView) {
-            const Vector3& position = mRegistry.get<PositionComponent>(spaceship).Position;
-            const Vector2 flatPosition = {position.x, position.z};
-            constexpr float radius =
-            std::max(SpaceshipData::CollisionRadius, SpaceshipData::ParticleCollisionRadius);
-            const Vector2 min = {flatPosition.x - radius, flatPosition.y - radius};
-            const Vector2 max = {flatPosition.x + radius, flatPosition.y + radius};
-            mSpatialPartition.InsertDeferred({spaceship, radius}, min, max);
-        }
+void Simulation::UpdatePartition()
+{
+    ZoneScoped;
+    ScopedSimPhase phase(mTimings, SimPhase::Partition);
+    if (Settings.IncrementalPartition != mPartitionIncremental) {
+        // The two modes don't share state, start the new one from scratch
+        mSpatialPartition.Reset();
+        mRegistry.clear<PartitionProxyComponent>();
+        mPartitionIncremental = Settings.IncrementalPartition;
     }
-
-    {
-        ZoneScopedN("FlushInsertions");
-        mSpatialPartition.FlushInsertions();
+    if (!mPartitionIncremental) {
+        mSpatialPartition.Clear();
     }
 
-    auto findCoordinateGap = [](float coord1, float coord2, float mod) {
-        float coordGap = coord2 - coord1;
-        if (abs(coordGap + mod) < abs(coordGap)) {
-            return coordGap + mod;
-        } else if (abs(coordGap - mod) < abs(coordGap)) {
-            return coordGap - mod;
+    auto partition = [this](entt::entity entity, const Vector3& position, float radius) {
+        const Vector2 flatPosition = {position.x, position.z};
+        const Vector2 min = {flatPosition.x - radius, flatPosition.y - radius};
+        const Vector2 max = {flatPosition.x + radius, flatPosition.y + radius};
+        if (!mPartitionIncremental) {
+            mSpatialPartition.InsertDeferred({entity, radius}, min, max);
+        } else if (auto* proxy = mRegistry.try_get<PartitionProxyComponent>(entity)) {
+            // Only touches the cells when the footprint changed, which drifting asteroids seldom do
+            mSpatialPartition.Move(proxy->Handle, {entity, radius}, min, max);
+        } else {
+            mRegistry.emplace<PartitionProxyComponent>(entity,
+                                                       mSpatialPartition.Insert({entity, radius}, min, max));
         }
-        return coordGap;
     };
 
-    auto findVectorGap = [findCoordinateGap](const Vector3& from, const Vector3& to) {
-        const float x1 = from.x;
-        const float x2 = to.x;
-        const float gapX = findCoordinateGap(x1, x2, SpaceData::LengthX);
-
-        const float z1 = from.z;
-        const float z2 = to.z;
-        const float gapZ = findCoordinateGap(z1, z2, SpaceData::LengthZ);
-
-        return Vector3{gapX, to.y - from.y, gapZ};
+    auto asteroidView = mRegistry.view<PositionComponent, AsteroidComponent>();
+    auto partitionAsteroids = [&](entt::entity asteroid, const PositionComponent& positionComponent,
+                                  const AsteroidComponent& asteroidComponent) {
+        partition(asteroid, positionComponent.Position, asteroidComponent.Radius);
     };
+    asteroidView.each(partitionAsteroids);
 
-    {
-        ZoneScopedN("Collide");
-        auto collisionHandler = [&](CollisionPayload collider1, CollisionPayload collider2) {
-            const Vector3& position1 = mRegistry.get<PositionComponent>(collider1.Entity).Position;
-            const Vector3& position2 = mRegistry.get<PositionComponent>(collider2.Entity).Position;
-
-            const Vector3 gap = findVectorGap(position1, position2);
+    auto playerCollisionView = mRegistry.view<PositionComponent, SpaceshipInputComponent>();
+    for (auto spaceship : playerCollisionView) {
+        constexpr float radius =
+        std::max(SpaceshipData::CollisionRadius, SpaceshipData::ParticleCollisionRadius);
+        partition(spaceship, mRegistry.get<PositionComponent>(spaceship).Position, radius);
+    }
+}
 
-            Vector3& velocity1 = mRegistry.get<VelocityComponent>(collider1.Entity).Velocity;
-            Vector3& velocity2 = mRegistry.get<VelocityComponent>(collider2.Entity).Velocity;
-            const Vector3 relativeVelocity = Vector3Subtract(velocity2, velocity1);
+void Simulation::FlushPartition()
+{
+    ZoneScoped;
+    ScopedSimPhase phase(mTimings, SimPhase::FlushInsertions);
+    if (mPartitionIncremental) {
+        mSpatialPartition.FlushUpdates();
+    } else {
+        mSpatialPartition.FlushInsertions();
+    }
+}
 
-            float projection = Vector3DotProduct(gap, relativeVelocity);
-            if (projection >= 0.f) {
-                return;
-            }
+void Simulation::CollideBodies()
+{
+    ZoneScoped;
+    ScopedSimPhase phase(mTimings, SimPhase::Collide);
+    const auto& positionStorage = mRegistry.storage<PositionComponent>();
+    auto& velocityStorage = mRegistry.storage<VelocityComponent>();
+    const auto& velocities = velocityStorage;
+    const auto& spaceshipStorage = mRegistry.storage<SpaceshipInputComponent>();
+
+    // Response of both colliders computed from their current velocities, only reads the registry
+    auto computeCollision = [&](CollisionPayload collider1, CollisionPayload collider2,
+                                CollisionImpulse& response1, CollisionImpulse& response2) {
+        const Vector3& position1 = positionStorage.get(collider1.Entity).Position;
+        const Vector3& position2 = positionStorage.get(collider2.Entity).Position;
+
+        const Vector3 gap = FindVectorGap(position1, position2);
+
+        const Vector3& velocity1 = velocities.get(collider1.Entity).Velocity;
+        const Vector3& velocity2 = velocities.get(collider2.Entity).Velocity;
+        const Vector3 relativeVelocity = Vector3Subtract(velocity2, velocity1);
+
+        float projection = Vector3DotProduct(gap, relativeVelocity);
+        if (projection >= 0.f) {
+            return false;
+        }
 
-            bool isSpaceship1 = mRegistry.all_of<SpaceshipInputComponent>(collider1.Entity);
-            bool isSpaceship2 = mRegistry.all_of<SpaceshipInputComponent>(collider2.Entity);
-            assert(isSpaceship1 || mRegistry.all_of<AsteroidComponent>(collider1.Entity));
-            assert(isSpaceship2 || mRegistry.all_of<AsteroidComponent>(collider2.Entity));
+        bool isSpaceship1 = spaceshipStorage.contains(collider1.Entity);
+        bool isSpaceship2 = spaceshipStorage.contains(collider2.Entity);
+        assert(isSpaceship1 || std::as_const(mRegistry).all_of<AsteroidComponent>(collider1.Entity));
+        assert(isSpaceship2 || std::as_const(mRegistry).all_of<AsteroidComponent>(collider2.Entity));
 
-            static_assert(SpaceshipData::CollisionRadius < SpaceshipData::ParticleCollisionRadius);
-            float minDistance = 0.f;
-            minDistance += (isSpaceship1) ? SpaceshipData::CollisionRadius : collider1.Radius;
-            minDistance += (isSpaceship2) ? SpaceshipData::CollisionRadius : collider2.Radius;
-            float distanceSq = gap.x * gap.x + gap.z * gap.z;
+        static_assert(SpaceshipData::CollisionRadius < SpaceshipData::ParticleCollisionRadius);
+        float minDistance = 0.f;
+        minDistance += (isSpaceship1) ? SpaceshipData::CollisionRadius : collider1.Radius;
+        minDistance += (isSpaceship2) ? SpaceshipData::CollisionRadius : collider2.Radius;
+        float distanceSq = gap.x * gap.x + gap.z * gap.z;
 
-            if (distanceSq > minDistance * minDistance) {
-                return;
-            }
+        if (distanceSq > minDistance * minDistance) {
+            return false;
+        }
 
-            const Vector3 transferedvelocity = Vector3Scale(gap, projection / distanceSq);
-            const float mass1 = (!isSpaceship1 ? SpaceData::RelativeAsteroidDensity : 1.f) *
-                                collider1.Radius * collider1.Radius * collider1.Radius;
-            const float mass2 = (!isSpaceship2 ? SpaceData::RelativeAsteroidDensity : 1.f) *
-                                collider2.Radius * collider2.Radius * collider2.Radius;
-            const float normalizer = 2.f * SpaceData::AsteroidBounce / (mass1 + mass2);
-            const Vector3 impact1 = Vector3Scale(transferedvelocity, mass2 * normalizer);
-            const Vector3 impact2 = Vector3Scale(transferedvelocity, -mass1 * normalizer);
-
-            velocity1 = Vector3Add(velocity1, impact1);
-            velocity2 = Vector3Add(velocity2, impact2);
-
-            if (isSpaceship1) {
-                if (Vector3LengthSqr(impact1) > SpaceshipData::LethalImpactSq) {
-                    mRegistry.get_or_emplace<DestroyComponent>(collider1.Entity);
-                } else {
-                    Vector3 radial = Vector3Subtract(velocity1, transferedvelocity);
-                    float angular = Vector3Length(radial) * SpaceshipData::AngularMomentumTransfer;
-                    float orthogonal = Vector3DotProduct(HorizontalOrthogonal(transferedvelocity), radial);
-                    if (orthogonal < 0.f) {
-                        angular = -angular;
-                    }
-                    mRegistry.get<AngularComponent>(collider1.Entity).YawMomentum -= angular;
+        const Vector3 transferedvelocity = Vector3Scale(gap, projection / distanceSq);
+        const float mass1 = (!isSpaceship1 ? SpaceData::RelativeAsteroidDensity : 1.f) *
+                            collider1.Radius * collider1.Radius * collider1.Radius;
+        const float mass2 = (!isSpaceship2 ? SpaceData::RelativeAsteroidDensity : 1.f) *
+                            collider2.Radius * collider2.Radius * collider2.Radius;
+        const float normalizer = 2.f * SpaceData::AsteroidBounce / (mass1 + mass2);
+        const Vector3 impact1 = Vector3Scale(transferedvelocity, mass2 * normalizer);
+        const Vector3 impact2 = Vector3Scale(transferedvelocity, -mass1 * normalizer);
+
+        response1 = {collider1.Entity, impact1, 0.f, isSpaceship1, false};
+        response2 = {collider2.Entity, impact2, 0.f, isSpaceship2, false};
+
+        if (isSpaceship1) {
+            if (Vector3LengthSqr(impact1) > SpaceshipData::LethalImpactSq) {
+                response1.Lethal = true;
+            } else {
+                Vector3 radial = Vector3Subtract(Vector3Add(velocity1, impact1), transferedvelocity);
+                float angular = Vector3Length(radial) * SpaceshipData::AngularMomentumTransfer;
+                float orthogonal = Vector3DotProduct(HorizontalOrthogonal(transferedvelocity), radial);
+                if (orthogonal < 0.f) {
+                    angular = -angular;
                 }
+                response1.Angular = angular;
             }
-            if (isSpaceship2) {
-                if (Vector3LengthSqr(impact2) > SpaceshipData::LethalImpactSq) {
-                    mRegistry.get_or_emplace<DestroyComponent>(collider2.Entity);
-                } else {
-                    Vector3 radial = Vector3Add(velocity2, transferedvelocity);
-                    float angular = Vector3Length(radial) * SpaceshipData::AngularMomentumTransfer;
-                    float orthogonal = -Vector3DotProduct(HorizontalOrthogonal(transferedvelocity), radial);
-                    if (orthogonal < 0.f) {
-                        angular = -angular;
-                    }
-                    mRegistry.get<AngularComponent>(collider2.Entity).YawMomentum -= angular;
+        }
+        if (isSpaceship2) {
+            if (Vector3LengthSqr(impact2) > SpaceshipData::LethalImpactSq) {
+                response2.Lethal = true;
+            } else {
+                Vector3 radial = Vector3Add(Vector3Add(velocity2, impact2), transferedvelocity);
+                float angular = Vector3Length(radial) * SpaceshipData::AngularMomentumTransfer;
+                float orthogonal = -Vector3DotProduct(HorizontalOrthogonal(transferedvelocity), radial);
+                if (orthogonal < 0.f) {
+                    angular = -angular;
                 }
+                response2.Angular = angular;
             }
-        };
-        mSpatialPartition.IteratePairs(collisionHandler);
-    }
+        }
+        return true;
+    };
 
-    auto particleCollisionView =
-    mRegistry.view<ParticleComponent, PositionComponent, VelocityComponent>(entt::exclude<BulletComponent>);
+    auto applyImpulse = [&](const CollisionImpulse& impulse) {
+        Vector3& velocity = velocityStorage.get(impulse.Entity).Velocity;
+        velocity = Vector3Add(velocity, impulse.Impulse);
+        if (!impulse.Spaceship) {
+            return;
+        }
+        if (impulse.Lethal) {
+            mRegistry.get_or_emplace<DestroyComponent>(impulse.Entity);
+        } else {
+            mRegistry.get<AngularComponent>(impulse.Entity).YawMomentum -= impulse.Angular;
+        }
+    };
 
-    {
-        ZoneScopedN("ExplosionPush");
-        // Assuming the number of simultaneous explosions is low
-        for (auto explosion : explosionView) {
-            const Vector3& explosionPosition = mRegistry.get<PositionComponent>(explosion).Position;
-            const float explosionRadius = mRegistry.get<ExplosionComponent>(explosion).CurrentRadius;
-            auto particleExplosionProcess = [&](entt::entity particle, const ParticleComponent&,
-                                                const PositionComponent& positionComponent,
-                                                VelocityComponent& velocityComponent) {
-                const Vector3& particlePosition = mRegistry.get<PositionComponent>(particle).Position;
-                const float distanceSqr = Vector3DistanceSqr(explosionPosition, particlePosition);
-                if (distanceSqr < explosionRadius * explosionRadius && !FloatEquals(distanceSqr, 0.f)) {
-                    const Vector3 radial =
-                    Vector3Normalize(Vector3Subtract(particlePosition, explosionPosition));
-                    const Vector3 push = Vector3Scale(radial, deltaTime * ExplosionData::ParticleForce);
-                    velocityComponent.Velocity = Vector3Add(velocityComponent.Velocity, push);
+    auto collisionHandler = [&](CollisionPayload collider1, CollisionPayload collider2) {
+        CollisionImpulse response1;
+        CollisionImpulse response2;
+        if (!computeCollision(collider1, collider2, response1, response2)) {
+            return;
+        }
+        applyImpulse(response1);
+        applyImpulse(response2);
+    };
+
+    switch (Settings.Broadphase) {
+    case BroadphaseMode::SortedDedup:
+        mSpatialPartition.IteratePairs(collisionHandler);
+        break;
+    case BroadphaseMode::MinCorner:
+        mSpatialPartition.IteratePairsMinCorner(collisionHandler);
+        break;
+    case BroadphaseMode::ParallelMinCorner: {
+        // Chunks are made of whole cells and reduced in chunk order, so results don't depend on the
+        // thread count. All pairs see the velocities from before the stage.
+        constexpr size_t CellChunkSize = 8;
+        const size_t cellCount = mSpatialPartition.PackedCellCount();
+        const size_t chunkCount = (cellCount + CellChunkSize - 1) / CellChunkSize;
+        if (mCollideChunks.size() < chunkCount) {
+            mCollideChunks.resize(chunkCount);
+        }
+        auto collideChunk = [&](size_t chunkIndex, size_t first, size_t last) {
+            std::vector<CollisionImpulse>& impulses = mCollideChunks[chunkIndex];
+            impulses.clear();
+            auto chunkHandler = [&](CollisionPayload collider1, CollisionPayload collider2) {
+                CollisionImpulse response1;
+                CollisionImpulse response2;
+                if (computeCollision(collider1, collider2, response1, response2)) {
+                    impulses.push_back(response1);
+                    impulses.push_back(response2);
                 }
             };
-            particleCollisionView.each(particleExplosionProcess);
+            mSpatialPartition.IteratePairsMinCorner(first, last, chunkHandler);
+        };
+        RunChunks(mThreadPool, mCollideTasks, cellCount, CellChunkSize, collideChunk);
+
+        for (size_t chunkIndex = 0; chunkIndex < chunkCount; ++chunkIndex) {
+            for (const CollisionImpulse& impulse : mCollideChunks[chunkIndex]) {
+                applyImpulse(impulse);
+            }
         }
+        break;
+    }
     }
+}
 
-    {
+void Simulation::PushParticles()
+{
+    ZoneScoped;
+    ScopedSimPhase phase(mTimings, SimPhase::ExplosionPush);
+    auto explosionView = mRegistry.view<ExplosionComponent, PositionComponent>();
+    // Assuming the number of simultaneous explosions is low
+    for (auto explosion : explosionView) {
+        const Vector3& explosionPosition = mRegistry.get<PositionComponent>(explosion).Position;
+        const float explosionRadius = mRegistry.get<ExplosionComponent>(explosion).CurrentRadius;
+        for (size_t index = 0; index < mParticles.Size(); ++index) {
+            const Vector3 particlePosition = mParticles.GetPosition(index);
+            const float distanceSqr = Vector3DistanceSqr(explosionPosition, particlePosition);
+            if (distanceSqr < explosionRadius * explosionRadius && !FloatEquals(distanceSqr, 0.f)) {
+                const Vector3 radial =
+                Vector3Normalize(Vector3Subtract(particlePosition, explosionPosition));
+                const Vector3 push = Vector3Scale(radial, DeltaTime * ExplosionData::ParticleForce);
+                mParticles.SetVelocity(index, Vector3Add(mParticles.GetVelocity(index), push));
+            }
+        }
+    }
+}
+
+void Simulation::CollideParticles()
+{
+    ZoneScoped;
+    ScopedSimPhase phase(mTimings, SimPhase::ParticleCollision);
+    constexpr size_t ChunkSize = 1024;
+
+    // Workers only read the registry, and each bounces the pool particles of its own chunk
+    const auto& positionStorage = mRegistry.storage<PositionComponent>();
+    const auto& velocityStorage = mRegistry.storage<VelocityComponent>();
+    const auto& partition = mSpatialPartition;
+    ParticlePool& particles = mParticles;
+
+    auto particleCollisionChunk = [&](size_t chunkIndex, size_t first, size_t last) {
+        for (size_t index = first; index < last; ++index) {
+            const Vector3 particlePosition = particles.GetPosition(index);
+            const Vector3 particleVelocity = particles.GetVelocity(index);
 
-        ZoneScopedN("ParticleCollision");
-        auto particleCollisionProcess = [&](entt::entity particle, const ParticleComponent&,
-                                            const PositionComponent& positionComponent,
-                                            VelocityComponent& velocityComponent) {
             auto particleCollisionHandler = [&](CollisionPayload collider) {
-                const Vector3& colliderVelocity = mRegistry.get<VelocityComponent>(collider.Entity).Velocity;
-                const Vector3 impactVelocity = Vector3Subtract(velocityComponent.Velocity, colliderVelocity);
+                const Vector3& colliderVelocity = velocityStorage.get(collider.Entity).Velocity;
+                const Vector3 impactVelocity = Vector3Subtract(particleVelocity, colliderVelocity);
 
-                const Vector3& colliderPosition = mRegistry.get<PositionComponent>(collider.Entity).Position;
-                const Vector3 toCollider = findVectorGap(positionComponent.Position, colliderPosition);
+                const Vector3& colliderPosition = positionStorage.get(collider.Entity).Position;
+                const Vector3 toCollider = FindVectorGap(particlePosition, colliderPosition);
 
                 if (Vector3DotProduct(impactVelocity, toCollider) <= 0.f) {
                     return false;
@@ -632,82 +845,79 @@ void Simulation::Simulate()
                     return false;
                 }
 
-                static_assert(SpaceshipData::CollisionRadius < SpaceshipData::ParticleCollisionRadius);
-                if (mRegistry.all_of<SpaceshipInputComponent>(collider.Entity) &&
-                    mRegistry.all_of<BulletComponent>(particle)) {
-                    if (distanceSqr > SpaceshipData::CollisionRadius * SpaceshipData::CollisionRadius) {
-                        return false;
-                    }
-                }
-
-                ParticleCollisionComponent& particleCollision =
-                mRegistry.get_or_emplace<ParticleCollisionComponent>(particle);
-                particleCollision.ImpactNormal = Vector3Normalize(toCollider);
-                particleCollision.NormalContactSpeed =
-                abs(Vector3DotProduct(impactVelocity, particleCollision.ImpactNormal));
-                particleCollision.Collider = collider.Entity;
+                const Vector3 impactNormal = Vector3Normalize(toCollider);
+                const float normalContactSpeed = abs(Vector3DotProduct(impactVelocity, impactNormal));
+                particles.SetVelocity(
+                index, Vector3Subtract(particleVelocity, Vector3Scale(impactNormal, 2.f * normalContactSpeed)));
 
                 return true;
             };
 
-            const Vector2 flatPosition = {positionComponent.Position.x, positionComponent.Position.z};
-            mSpatialPartition.IterateNearby(flatPosition, flatPosition, particleCollisionHandler);
-        };
-        particleCollisionView.each(particleCollisionProcess);
-    }
-
-    {
-        ZoneScopedN("BulletCollision");
-        auto bulletCollisionView = mRegistry.view<BulletComponent, PositionComponent, VelocityComponent>();
-        auto bulletCollisionProcess = [&](entt::entity bullet, const PositionComponent& positionComponent,
-                                          VelocityComponent& velocityComponent) {
-            auto bulletCollisionHandler = [&](CollisionPayload collider) {
-                const float radius = mRegistry.all_of<SpaceshipInputComponent>(collider.Entity) ?
-                                     SpaceshipData::CollisionRadius :
-                                     collider.Radius;
-
-                const Vector3& colliderPosition = mRegistry.get<PositionComponent>(collider.Entity).Position;
-                const Vector3 dp = findVectorGap(positionComponent.Position, colliderPosition);
-
-                const Vector3& colliderVelocity = mRegistry.get<VelocityComponent>(collider.Entity).Velocity;
-                const Vector3 dv = Vector3Subtract(colliderVelocity, velocityComponent.Velocity);
-
-                // Quadratic terms:
-                const float a = Vector3LengthSqr(dv);
-                const float b = 2.f * Vector3DotProduct(dp, dv);
-                const float c = Vector3LengthSqr(dp) - (radius * radius);
+            const Vector2 flatPosition = {particlePosition.x, particlePosition.z};
+            partition.IterateNearbyPoint(flatPosition, particleCollisionHandler);
+        }
+    };
+    RunChunks(mThreadPool, mParticleCollisionTasks, particles.Size(), ChunkSize, particleCollisionChunk);
+}
 
-                const float determinant = b * b - (4.f * a * c);
-                if (determinant < 0.f) {
-                    return false;
-                }
+void Simulation::CollideBullets()
+{
+    ZoneScoped;
+    ScopedSimPhase phase(mTimings, SimPhase::BulletCollision);
+    auto bulletCollisionView = mRegistry.view<BulletComponent, PositionComponent, VelocityComponent>();
+    auto bulletCollisionProcess = [&](entt::entity bullet, const PositionComponent& positionComponent,
+                                      VelocityComponent& velocityComponent) {
+        auto bulletCollisionHandler = [&](CollisionPayload collider) {
+            const float radius = mRegistry.all_of<SpaceshipInputComponent>(collider.Entity) ?
+                                 SpaceshipData::CollisionRadius :
+                                 collider.Radius;
+
+            const Vector3& colliderPosition = mRegistry.get<PositionComponent>(collider.Entity).Position;
+            const Vector3 dp = FindVectorGap(positionComponent.Position, colliderPosition);
+
+            const Vector3& colliderVelocity = mRegistry.get<VelocityComponent>(collider.Entity).Velocity;
+            const Vector3 dv = Vector3Subtract(colliderVelocity, velocityComponent.Velocity);
+
+            // Quadratic terms:
+            const float a = Vector3LengthSqr(dv);
+            const float b = 2.f * Vector3DotProduct(dp, dv);
+            const float c = Vector3LengthSqr(dp) - (radius * radius);
+
+            const float determinant = b * b - (4.f * a * c);
+            if (determinant < 0.f) {
+                return false;
+            }
 
-                const float sqrtDeterminant = sqrt(determinant);
+            const float sqrtDeterminant = sqrt(determinant);
 
-                const float contactTime = -0.5f * (b + sqrtDeterminant) / a;
+            const float contactTime = -0.5f * (b + sqrtDeterminant) / a;
 
-                if (contactTime > 0.f || contactTime < -deltaTime) {
-                    return false;
-                }
-
-                const Vector3 relativeContactPosition = Vector3Add(dp, Vector3Scale(dv, contactTime));
+            if (contactTime > 0.f || contactTime < -DeltaTime) {
+                return false;
+            }
 
-                ParticleCollisionComponent& particleCollision =
-                mRegistry.get_or_emplace<ParticleCollisionComponent>(bullet);
-                particleCollision.ImpactNormal = Vector3Normalize(relativeContactPosition);
-                particleCollision.NormalContactSpeed =
-                abs(Vector3DotProduct(dv, particleCollision.ImpactNormal));
-                particleCollision.Collider = collider.Entity;
+            const Vector3 relativeContactPosition = Vector3Add(dp, Vector3Scale(dv, contactTime));
 
-                return true;
-            };
+            ParticleCollisionComponent& particleCollision =
+            mRegistry.get_or_emplace<ParticleCollisionComponent>(bullet);
+            particleCollision.ImpactNormal = Vector3Normalize(relativeContactPosition);
+            particleCollision.NormalContactSpeed =
+            abs(Vector3DotProduct(dv, particleCollision.ImpactNormal));
+            particleCollision.Collider = collider.Entity;
 
-            const Vector2 flatPosition = {positionComponent.Position.x, positionComponent.Position.z};
-            mSpatialPartition.IterateNearby(flatPosition, flatPosition, bulletCollisionHandler);
+            return true;
         };
-        bulletCollisionView.each(bulletCollisionProcess);
-    }
 
+        const Vector2 flatPosition = {positionComponent.Position.x, positionComponent.Position.z};
+        mSpatialPartition.IterateNearbyPoint(flatPosition, bulletCollisionHandler);
+    };
+    bulletCollisionView.each(bulletCollisionProcess);
+}
+
+void Simulation::ResolveBulletCollisions()
+{
+    ZoneScoped;
+    ScopedSimPhase phase(mTimings, SimPhase::PostCollision);
     auto bulletPostCollisionView =
     mRegistry.view<ParticleCollisionComponent, BulletComponent, VelocityComponent>();
     auto bulletPostCollisionProcess = [&](entt::entity bullet, ParticleCollisionComponent& collision,
@@ -733,9 +943,13 @@ void Simulation::Simulate()
         velocityComponent.Velocity = bounceVelocity;
     };
     particlePostCollisionView.each(particlePostCollisionProcess);
-
     mRegistry.clear<ParticleCollisionComponent>();
+}
 
+void Simulation::ResolveHits()
+{
+    ZoneScoped;
+    ScopedSimPhase phase(mTimings, SimPhase::Hits);
     auto hitAsteroidView = mRegistry.view<AsteroidComponent, BulletHitComponent>();
     auto hitAsteroidProcess = [&](entt::entity asteroid, const AsteroidComponent& asteroidComponent,
                                   const BulletHitComponent& hitComponent) {
@@ -746,7 +960,7 @@ void Simulation::Simulate()
         constexpr float MaxDestroyChance = 0.25f;
         const float destroyChance =
         sqrt(std::clamp(relativeRadius, 0.f, 1.f)) * (MinDestroyChance - MaxDestroyChance) + MaxDestroyChance;
-        if (UniformDistribution(mRandomGenerator) >= destroyChance * hitComponent.HitCos) {
+        if (mHitRandom.Uniform() >= destroyChance * hitComponent.HitCos) {
             return;
         }
         mRegistry.emplace<DestroyComponent>(asteroid);
@@ -756,21 +970,25 @@ void Simulation::Simulate()
     auto hitSpaceshipView = mRegistry.view<SpaceshipInputComponent, BulletHitComponent>();
     auto hitSpaceshipProcess = [&](entt::entity spaceship, const SpaceshipInputComponent& spaceshipComponent,
                                    const BulletHitComponent& hitComponent) {
-        if (UniformDistribution(mRandomGenerator) < 0.8f) {
+        if (mHitRandom.Uniform() < 0.8f) {
             return;
         }
         mRegistry.emplace<DestroyComponent>(spaceship);
     };
     hitSpaceshipView.each(hitSpaceshipProcess);
-
     mRegistry.clear<BulletHitComponent>();
+}
 
+void Simulation::Shoot()
+{
+    ZoneScoped;
+    ScopedSimPhase phase(mTimings, SimPhase::Shoot);
     auto shootView =
     mRegistry.view<PositionComponent, VelocityComponent, OrientationComponent, SpaceshipInputComponent, GunComponent>();
     auto shootProcess = [this](const PositionComponent& positionComponent, const VelocityComponent& velocityComponent,
                                const OrientationComponent& orientationComponent,
                                const SpaceshipInputComponent& inputComponent, GunComponent& gunComponent) {
-        gunComponent.TimeSinceLastShot += deltaTime;
+        gunComponent.TimeSinceLastShot += DeltaTime;
         if (!inputComponent.Input.Fire) {
             return;
         }
@@ -796,7 +1014,12 @@ void Simulation::Simulate()
         gunComponent.TimeSinceLastShot = 0.f;
     };
     shootView.each(shootProcess);
+}
 
+void Simulation::DestroyBodies()
+{
+    ZoneScoped;
+    ScopedSimPhase phase(mTimings, SimPhase::Destruction);
     auto destroyedAsteroidsView =
     mRegistry.view<AsteroidComponent, PositionComponent, VelocityComponent, DestroyComponent>();
     auto destroyedAsteroidProcess = [this](const AsteroidComponent& asteroidComponent,
@@ -805,19 +1028,19 @@ void Simulation::Simulate()
         const float radius = asteroidComponent.Radius;
         const Vector3& position = positionComponent.Position;
         const Vector3& velocity = velocityComponent.Velocity;
-        MakeExplosion(position, velocity, radius * ExplosionData::AsteroidMultiplier);
+        MakeExplosion(mCommands, mDestructionRandom, position, velocity, radius * ExplosionData::AsteroidMultiplier);
         const float breakRadius = 0.5f * radius;
         if (breakRadius > SpaceData::MinAsteroidRadius * 0.5f) {
 
-            const float axisAngle = DirectionDistribution(mRandomGenerator);
+            const float axisAngle = mDestructionRandom.Uniform(0.f, 2.f * PI);
             const Vector3 axis = {cos(axisAngle), 0.f, sin(axisAngle)};
 
-            const float randomSpeedAngle = DirectionDistribution(mRandomGenerator);
+            const float randomSpeedAngle = mDestructionRandom.Uniform(0.f, 2.f * PI);
             const Vector3 speedDrift = {cos(axisAngle), 0.f, sin(axisAngle)};
 
-            MakeAsteroid(mRegistry, breakRadius, Vector3Add(position, Vector3Scale(axis, breakRadius)),
+            MakeAsteroid(mCommands, breakRadius, Vector3Add(position, Vector3Scale(axis, breakRadius)),
                          Vector3Add(velocity, speedDrift));
-            MakeAsteroid(mRegistry, radius - breakRadius,
+            MakeAsteroid(mCommands, radius - breakRadius,
                          Vector3Subtract(position, Vector3Scale(axis, radius - breakRadius)),
                          Vector3Subtract(velocity, speedDrift));
         }
@@ -829,16 +1052,319 @@ void Simulation::Simulate()
     auto destroyedSpaceshipProcess = [&](entt::entity spaceship, const SpaceshipInputComponent& inputComponent,
                                          const PositionComponent& positionComponent,
                                          const VelocityComponent& velocityComponent) {
-        entt::entity respawner = mRegistry.create();
-        mRegistry.emplace<RespawnComponent>(respawner, inputComponent.InputId, RespawnData::Timer);
-        mRegistry.emplace<PositionComponent>(respawner, DefaultPlayerPosition(inputComponent.InputId));
+        DeferredEntity respawner = mCommands.Create();
+        mCommands.Emplace(respawner, RespawnComponent{inputComponent.InputId, RespawnData::Timer});
+        mCommands.Emplace(respawner, PositionComponent{DefaultPlayerPosition(inputComponent.InputId)});
 
-        MakeExplosion(positionComponent.Position, velocityComponent.Velocity, ExplosionData::SpaceshipRadius);
+        MakeExplosion(mCommands, mDestructionRandom, positionComponent.Position, velocityComponent.Velocity,
+                      ExplosionData::SpaceshipRadius);
     };
     destroyedSpaceshipView.each(destroyedSpaceshipProcess);
+    mCommands.Playback(mRegistry);
+}
+
+namespace SimAccess {
+enum : AccessMask
+{
+    Entities = 1ull << 0,
+    Position = 1ull << 1,
+    Velocity = 1ull << 2,
+    Orientation = 1ull << 3,
+    Angular = 1ull << 4,
+    Steer = 1ull << 5,
+    Thrust = 1ull << 6,
+    SpaceshipInput = 1ull << 7,
+    Gun = 1ull << 8,
+    Asteroid = 1ull << 9,
+    Particle = 1ull << 10, // ParticleComponent, bullets only
+    Bullet = 1ull << 11,
+    Destroy = 1ull << 12,
+    BulletHit = 1ull << 13,
+    Respawn = 1ull << 14,
+    ParticleCollision = 1ull << 15,
+    Explosion = 1ull << 16,
+    Maneuver = 1ull << 17, // SpecialManeuver
+    PartitionProxy = 1ull << 18,
+    Partition = 1ull << 19, // mSpatialPartition
+    Particles = 1ull << 20, // mParticles
+    All = ~0ull,
+};
+}
+
+void Simulation::BuildSystems()
+{
+    using namespace SimAccess;
+
+    // Pools are created up front so systems running side by side never insert into the registry pool map
+    mRegistry.storage<PositionComponent>();
+    mRegistry.storage<VelocityComponent>();
+    mRegistry.storage<OrientationComponent>();
+    mRegistry.storage<AngularComponent>();
+    mRegistry.storage<SteerComponent>();
+    mRegistry.storage<ThrustComponent>();
+    mRegistry.storage<SpaceshipInputComponent>();
+    mRegistry.storage<GunComponent>();
+    mRegistry.storage<AsteroidComponent>();
+    mRegistry.storage<ParticleComponent>();
+    mRegistry.storage<BulletComponent>();
+    mRegistry.storage<DestroyComponent>();
+    mRegistry.storage<BulletHitComponent>();
+    mRegistry.storage<RespawnComponent>();
+    mRegistry.storage<ParticleCollisionComponent>();
+    mRegistry.storage<ExplosionComponent>();
+    mRegistry.storage<SpecialManeuver>();
+    mRegistry.storage<PartitionProxyComponent>();
+
+    // Declared in the serial order, the graph only reorders systems whose accesses don't conflict
+    auto add = [this](const char* name, AccessMask reads, AccessMask writes, void (Simulation::*system)()) {
+        mSystems.AddNode(name, reads, writes, [this, system]() {
+            (this->*system)();
+        });
+    };
+    add("Destroy", 0, All, &Simulation::DestroyEntities);
+    add("Respawn", 0, All, &Simulation::UpdateRespawners);
+    add("Explosions", Entities | Position, Explosion | Destroy, &Simulation::UpdateExplosions);
+    add("Angular", 0, Angular | Orientation, &Simulation::UpdateAngular);
+    add("Players", Entities | SpaceshipInput, Velocity | Orientation | Steer | Thrust | Maneuver,
+        &Simulation::UpdatePlayers);
+    add("Thrust", Thrust | Position | Velocity | Orientation | SpaceshipInput, Particles,
+        &Simulation::EmitThrustParticles);
+    add("BulletLifetime", Entities, Particle | Destroy, &Simulation::UpdateBulletLifetimes);
+    add("ParticleLifetime", 0, Particles, &Simulation::UpdateParticleLifetimes);
+    add("ParticleIntegrate", 0, Particles, &Simulation::IntegrateParticles);
+    add("Dynamics", Velocity, Position, &Simulation::IntegrateDynamics);
+    add("Wrap", 0, Position, &Simulation::WrapPositions);
+    add("Partition", Entities | Position | Asteroid | SpaceshipInput, Partition | PartitionProxy,
+        &Simulation::UpdatePartition);
+    add("FlushInsertions", 0, Partition, &Simulation::FlushPartition);
+    // IteratePairs fills the partition's pair accumulator
+    add("Collide", Entities | Position | SpaceshipInput | Asteroid, Partition | Velocity | Angular | Destroy,
+        &Simulation::CollideBodies);
+    add("ExplosionPush", Explosion | Position, Particles, &Simulation::PushParticles);
+    add("ParticleCollision", Partition | Position | Velocity, Particles, &Simulation::CollideParticles);
+    add("BulletCollision", Entities | Bullet | Partition | Position | Velocity | SpaceshipInput, ParticleCollision,
+        &Simulation::CollideBullets);
+    add("PostCollision", Entities | Bullet, ParticleCollision | Velocity | BulletHit | Destroy,
+        &Simulation::ResolveBulletCollisions);
+    add("Hits", Entities | Asteroid | SpaceshipInput, BulletHit | Destroy, &Simulation::ResolveHits);
+    add("Shoot", SpaceshipInput, Entities | Bullet | Position | Orientation | Velocity | Particle | Gun,
+        &Simulation::Shoot);
+    add("Destruction", 0, All, &Simulation::DestroyBodies);
+}
+
+void Simulation::Simulate()
+{
+    if (Settings.ParallelSystems) {
+        mSystems.Run(mThreadPool);
+    } else {
+        mSystems.RunSerial();
+    }
 
     mFrame++;
-    GameTime = deltaTime * mFrame;
+    GameTime = DeltaTime * mFrame;
+}
+
+namespace {
+// Keeps identical values from different sets apart in StateHash
+enum HashSalt : uint32_t
+{
+    FrameSalt = 1,
+    EntitySalt,
+    PositionSalt,
+    VelocitySalt,
+    OrientationSalt,
+    ParticleSalt,
+};
+} // namespace
+
+uint64_t Simulation::StateHash() const
+{
+    ZoneScoped;
+    StateHasher hasher;
+    hasher.AddId(FrameSalt, mFrame);
+    mRegistry.each([&hasher](entt::entity entity) {
+        hasher.AddId(EntitySalt, entt::to_integral(entity));
+    });
+    for (auto [entity, position] : mRegistry.view<PositionComponent>().each()) {
+        hasher.AddElement(PositionSalt, entt::to_integral(entity), position);
+    }
+    for (auto [entity, velocity] : mRegistry.view<VelocityComponent>().each()) {
+        hasher.AddElement(VelocitySalt, entt::to_integral(entity), velocity);
+    }
+    for (auto [entity, orientation] : mRegistry.view<OrientationComponent>().each()) {
+        hasher.AddElement(OrientationSalt, entt::to_integral(entity), orientation);
+    }
+    const std::array<const float*, 7> particleColumns = {
+    mParticles.PositionsX.data(),  mParticles.PositionsY.data(),  mParticles.PositionsZ.data(),
+    mParticles.VelocitiesX.data(), mParticles.VelocitiesY.data(), mParticles.VelocitiesZ.data(),
+    mParticles.LifeTimes.data()};
+    hasher.AddFloatRows(ParticleSalt, particleColumns, mParticles.Size());
+    return hasher.Digest();
+}
+
+namespace {
+// Storages in snapshots. PartitionProxyComponent is left out, the partition is rebuilt after loading.
+using SnapshotComponents = std::tuple<SteerComponent,
+                                      GunComponent,
+                                      ThrustComponent,
+                                      PositionComponent,
+                                      OrientationComponent,
+                                      VelocityComponent,
+                                      AngularComponent,
+                                      SpecialManeuver,
+                                      SpaceshipInputComponent,
+                                      AsteroidComponent,
+                                      ParticleComponent,
+                                      BulletComponent,
+                                      DestroyComponent,
+                                      BulletHitComponent,
+                                      RespawnComponent,
+                                      ParticleCollisionComponent,
+                                      ExplosionComponent>;
+
+enum SnapshotId : uint32_t
+{
+    EntitiesId = 1,
+    RandomId,
+    ParticleColorsId,
+    ParticleColumnsId,                  // One section per ParticlePool::FloatColumns
+    StoragesId = ParticleColumnsId + 8, // Entities, then values unless empty, of each SnapshotComponents storage
+};
+
+constexpr uint32_t StorageId(size_t index)
+{
+    return StoragesId + 2 * static_cast<uint32_t>(index);
+}
+
+template <typename T>
+void SaveStorage(SnapshotWriter& writer, const entt::registry& registry, uint32_t id)
+{
+    const auto& storage = registry.storage<T>();
+    const entt::entity* entities = storage.data();
+    writer.Write(id, entities, storage.size());
+    if constexpr (!std::is_empty_v<T>) {
+        // In packed order, so loading gives back the same iteration order
+        T* values = writer.Append<T>(id + 1, storage.size());
+        for (size_t index = 0; index < storage.size(); ++index) {
+            values[index] = storage.get(entities[index]);
+        }
+    }
+}
+
+template <typename T>
+bool CheckStorage(const SnapshotReader& reader, uint32_t id)
+{
+    const entt::entity* entities;
+    size_t count;
+    if (!reader.Read(id, entities, count)) {
+        return false;
+    }
+    if constexpr (!std::is_empty_v<T>) {
+        const T* values;
+        size_t valueCount;
+        return reader.Read(id + 1, values, valueCount) && valueCount == count;
+    }
+    return true;
+}
+
+template <typename T>
+void LoadStorage(const SnapshotReader& reader, entt::registry& registry, uint32_t id)
+{
+    const entt::entity* entities;
+    size_t count;
+    reader.Read(id, entities, count);
+    // One batch insert straight from the snapshot memory
+    if constexpr (std::is_empty_v<T>) {
+        registry.insert<T>(entities, entities + count);
+    } else {
+        const T* values;
+        size_t valueCount;
+        reader.Read(id + 1, values, valueCount);
+        registry.insert<T>(entities, entities + count, values);
+    }
+}
+
+template <size_t... Indices>
+void SaveStorages(SnapshotWriter& writer, const entt::registry& registry, std::index_sequence<Indices...>)
+{
+    (SaveStorage<std::tuple_element_t<Indices, SnapshotComponents>>(writer, registry, StorageId(Indices)), ...);
+}
+
+template <size_t... Indices>
+bool CheckStorages(const SnapshotReader& reader, std::index_sequence<Indices...>)
+{
+    return (CheckStorage<std::tuple_element_t<Indices, SnapshotComponents>>(reader, StorageId(Indices)) && ...);
+}
+
+template <size_t... Indices>
+void LoadStorages(const SnapshotReader& reader, entt::registry& registry, std::index_sequence<Indices...>)
+{
+    (LoadStorage<std::tuple_element_t<Indices, SnapshotComponents>>(reader, registry, StorageId(Indices)), ...);
+}
+
+constexpr auto SnapshotStorages = std::make_index_sequence<std::tuple_size_v<SnapshotComponents>>();
+} // namespace
+
+void Simulation::SaveSnapshot(std::vector<uint8_t>& buffer) const
+{
+    ZoneScoped;
+    SnapshotWriter writer(buffer);
+    writer.Write(EntitiesId, mRegistry.data(), mRegistry.size());
+    const std::array<SimRandom, 4> randoms = {mInitRandom, mThrustRandom, mHitRandom, mDestructionRandom};
+    writer.Write(RandomId, randoms.data(), randoms.size());
+    writer.Write(ParticleColorsId, mParticles.Colors.data(), mParticles.Size());
+    uint32_t columnId = ParticleColumnsId;
+    for (const std::vector<float>* column : mParticles.FloatColumns()) {
+        writer.Write(columnId++, column->data(), column->size());
+    }
+    SaveStorages(writer, mRegistry, SnapshotStorages);
+    writer.Finish(mFrame, entt::to_integral(mRegistry.released()));
+}
+
+bool Simulation::LoadSnapshot(const uint8_t* data, size_t size)
+{
+    ZoneScoped;
+    SnapshotReader reader;
+    if (!reader.Open(data, size)) {
+        return false;
+    }
+    const entt::entity* entities;
+    size_t entityCount;
+    const SimRandom* randoms;
+    size_t randomCount;
+    const Color* colors;
+    size_t particleCount;
+    bool valid = reader.Read(EntitiesId, entities, entityCount) && reader.Read(RandomId, randoms, randomCount) &&
+                 randomCount == 4 && reader.Read(ParticleColorsId, colors, particleCount) &&
+                 CheckStorages(reader, SnapshotStorages);
+    std::array<const float*, 7> columns;
+    for (uint32_t column = 0; column < columns.size(); ++column) {
+        size_t count;
+        valid = valid && reader.Read(ParticleColumnsId + column, columns[column], count) && count == particleCount;
+    }
+    if (!valid) {
+        return false;
+    }
+
+    mRegistry.clear();
+    mRegistry.assign(entities, entities + entityCount, entt::entity{reader.ReleasedEntity()});
+    LoadStorages(reader, mRegistry, SnapshotStorages);
+
+    mInitRandom = randoms[0];
+    mThrustRandom = randoms[1];
+    mHitRandom = randoms[2];
+    mDestructionRandom = randoms[3];
+
+    mParticles.Colors.assign(colors, colors + particleCount);
+    const std::array<std::vector<float>*, 7> particleColumns = mParticles.FloatColumns();
+    for (uint32_t column = 0; column < columns.size(); ++column) {
+        particleColumns[column]->assign(columns[column], columns[column] + particleCount);
+    }
+
+    mFrame = reader.Frame();
+    GameTime = DeltaTime * mFrame;
+    ResetPartition();
+    return true;
 }
 
 void Simulation::Tick()
@@ -847,3 +1373,18 @@ void Simulation::Tick()
     ProcessInput(mRegistry, mGameInput);
     Simulate();
 }
+
+const ParticlePool& Simulation::GetParticles() const
+{
+    return mParticles;
+}
+
+uint32_t Simulation::GetFrame() const
+{
+    return mFrame;
+}
+
+void Simulation::SetTimings(SimTimings* timings)
+{
+    mTimings = timings;
+}
@@ -1,29 +1,103 @@
 #pragma once
 
+#include "Components.h"
 #include "Data.h"
 #include "DependencyContainer.h"
+#include "EntityCommandBuffer.h"
+#include "ParticlePool.h"
+#include "RenderSnapshot.h"
+#include "SimRandom.h"
+#include "SimTimings.h"
 #include "SpatialPartition.h"
+#include "ThreadPool/TaskGraph.h"
+#include "ThreadPool/ThreadPool.h"
 #include "entt/entt.hpp"
-#include <random>
 
 struct SimFlag
 {};
 using SimDependencies = DependencyContainer<SimFlag>;
 
+// Components the systems add from deferred passes
+using SimCommandBuffer = EntityCommandBuffer<PositionComponent,
+                                             VelocityComponent,
+                                             AsteroidComponent,
+                                             ExplosionComponent,
+                                             RespawnComponent,
+                                             SpecialManeuver,
+                                             DestroyComponent>;
+
+enum class BroadphaseMode
+{
+    SortedDedup,       // SpatialPartition::IteratePairs, dedups through a sorted pair accumulator
+    MinCorner,         // SpatialPartition::IteratePairsMinCorner, duplicate free by construction
+    ParallelMinCorner, // MinCorner over chunks of cells on the pool, impulses from pre-stage velocities
+};
+
+struct SimSettings
+{
+    BroadphaseMode Broadphase = BroadphaseMode::SortedDedup;
+    bool IncrementalPartition = false; // Keep partition slots across ticks instead of rebuilding every tick
+    bool ParallelSystems = true;       // Run non conflicting systems side by side on the pool
+    uint64_t Seed = 0;                 // Read by Init
+};
+
 class Simulation
 {
 public:
     Simulation(const SimDependencies& dependencies);
 
-    void Init(uint32_t players);
+    void Init(uint32_t players, uint32_t asteroids = SpaceData::AsteroidsCount);
     void Tick();
-    void WriteRenderState(entt::registry& target) const;
+    void WriteRenderState(RenderSnapshot& target) const;
+    // Digest of the entity set, positions, velocities, orientations and particles. It doesn't depend on storage
+    // order, so runs fed with the same seed, settings and input match as long as their states are bit-identical.
+    uint64_t StateHash() const;
+    // Flat binary copy of the registry, particles, random streams and frame (layout in SimSnapshot.h). The buffer's
+    // capacity is reused. Incremental partition slots aren't saved, loading rebuilds the partition on the next tick.
+    void SaveSnapshot(std::vector<uint8_t>& buffer) const;
+    // Replaces the whole state. False, with the state untouched, when data isn't a snapshot of this build's layout.
+    bool LoadSnapshot(const uint8_t* data, size_t size);
+    void SetTimings(SimTimings* timings);
+    const ParticlePool& GetParticles() const;
+    // Ticks simulated since Init, or restored by LoadSnapshot
+    uint32_t GetFrame() const;
 
     float GameTime;
+    SimSettings Settings;
 
 private:
+    void BuildSystems();
+    void ResetPartition();
     void Simulate();
-    void MakeExplosion(const Vector3& position, const Vector3& velocity, float radius);
+
+    // Systems, in serial order
+    void DestroyEntities();
+    void UpdateRespawners();
+    void UpdateExplosions();
+    void UpdateAngular();
+    void UpdatePlayers();
+    void EmitThrustParticles();
+    void UpdateBulletLifetimes();
+    void UpdateParticleLifetimes();
+    void IntegrateParticles();
+    void IntegrateDynamics();
+    void WrapPositions();
+    void UpdatePartition();
+    void FlushPartition();
+    void CollideBodies();
+    void PushParticles();
+    void CollideParticles();
+    void CollideBullets();
+    void ResolveBulletCollisions();
+    void ResolveHits();
+    void Shoot();
+    void DestroyBodies();
+
+    void MakeExplosion(SimCommandBuffer& commands,
+                       SimRandom& random,
+                       const Vector3& position,
+                       const Vector3& velocity,
+                       float radius);
 
     struct CollisionPayload
     {
@@ -31,9 +105,43 @@ private:
         float Radius;
     };
 
+    // Output of the parallel broadphase chunks, applied in chunk order once all are done
+    struct CollisionImpulse
+    {
+        entt::entity Entity;
+        Vector3 Impulse;
+        float Angular;
+        bool Spaceship;
+        bool Lethal;
+    };
+
     uint32_t mFrame = 0;
+    SimTimings* mTimings = nullptr;
     entt::registry& mRegistry;
     const std::array<GameInput, 2>& mGameInput;
     SpatialPartition<CollisionPayload> mSpatialPartition;
-    std::default_random_engine mRandomGenerator;
+    bool mPartitionIncremental = false;
+    // One stream per system drawing random numbers, so systems don't have to be ordered around a shared engine
+    SimRandom mInitRandom;
+    SimRandom mThrustRandom;
+    SimRandom mHitRandom;
+    SimRandom mDestructionRandom;
+    ParticlePool mParticles;
+
+    ThreadPool mThreadPool;
+    TaskGraph mSystems;
+    // One task list per chunked system, they may be in flight at the same time
+    std::vector<Task> mIntegrateTasks;
+    std::vector<Task> mCollideTasks;
+    std::vector<Task> mParticleCollisionTasks;
+    std::vector<Task> mAngularTasks;
+    std::vector<Task> mDynamicsTasks;
+    std::vector<Task> mWrapTasks;
+    std::vector<Task> mBulletLifetimeTasks;
+    std::vector<Task> mPlayerTasks;
+
+    SimCommandBuffer mCommands; // For systems running on a single thread
+    std::vector<SimCommandBuffer> mBulletLifetimeCommands;
+    std::vector<SimCommandBuffer> mPlayerCommands;
+    std::vector<std::vector<CollisionImpulse>> mCollideChunks;
 };
\ No newline at end of file
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <array>
+#include <cstring>
+#include <stdint.h>
+
+// Order independent digest of a set of elements: each element (a salt telling which set it belongs to, an id and
+// its value bits) is hashed on its own and the results are summed. The same elements give the same digest whatever
+// order storages keep them in, and digests of parts (chunks, storages) just add up. Bits are hashed as they are, so
+// only bit-identical states match.
+class StateHasher final
+{
+public:
+    // T is hashed as 32-bit words and must not have padding
+    template <typename T>
+    void AddElement(uint32_t salt, uint32_t id, const T& value)
+    {
+        static_assert(sizeof(T) % sizeof(uint32_t) == 0);
+        std::array<uint32_t, sizeof(T) / sizeof(uint32_t)> words;
+        std::memcpy(words.data(), &value, sizeof(T));
+        uint32_t hash = mixWord(salt, id);
+        for (uint32_t word : words) {
+            hash = mixWord(hash, word);
+        }
+        accumulate(hash);
+    }
+
+    void AddId(uint32_t salt, uint32_t id)
+    {
+        accumulate(mixWord(salt, id));
+    }
+
+    // Rows of parallel float arrays, each row is an element. Runs column by column over blocks of rows with no
+    // branches or cross-row dependencies, which compilers turn into SIMD code.
+    template <size_t Columns>
+    void AddFloatRows(uint32_t salt, const std::array<const float*, Columns>& columns, size_t count)
+    {
+        constexpr size_t Block = 256;
+        std::array<uint32_t, Block> hashes;
+        for (size_t first = 0; first < count; first += Block) {
+            const size_t rows = (count - first < Block) ? count - first : Block;
+            hashes.fill(salt);
+            for (const float* column : columns) {
+                for (size_t row = 0; row < rows; ++row) {
+                    uint32_t word;
+                    std::memcpy(&word, column + first + row, sizeof(word));
+                    hashes[row] = mixWord(hashes[row], word);
+                }
+            }
+            uint32_t low = 0;
+            uint32_t high = 0;
+            for (size_t row = 0; row < rows; ++row) {
+                low += finalize(hashes[row]);
+                high += finalize(hashes[row] ^ HighSeed);
+            }
+            mLow += low;
+            mHigh += high;
+        }
+    }
+
+    void Add(const StateHasher& other)
+    {
+        mLow += other.mLow;
+        mHigh += other.mHigh;
+    }
+
+    uint64_t Digest() const
+    {
+        return (static_cast<uint64_t>(mHigh) << 32) | mLow;
+    }
+
+private:
+    static constexpr uint32_t HighSeed = 0x9E3779B9;
+
+    // Murmur3 block and finalization steps
+    static uint32_t mixWord(uint32_t hash, uint32_t word)
+    {
+        word *= 0xCC9E2D51;
+        word = (word << 15) | (word >> 17);
+        word *= 0x1B873593;
+        hash ^= word;
+        hash = (hash << 13) | (hash >> 19);
+        return hash * 5 + 0xE6546B64;
+    }
+
+    static uint32_t finalize(uint32_t hash)
+    {
+        hash ^= hash >> 16;
+        hash *= 0x85EBCA6B;
+        hash ^= hash >> 13;
+        hash *= 0xC2B2AE35;
+        hash ^= hash >> 16;
+        return hash;
+    }
+
+    void accumulate(uint32_t hash)
+    {
+        mLow += finalize(hash);
+        mHigh += finalize(hash ^ HighSeed);
+    }
+
+    uint32_t mLow = 0;
+    uint32_t mHigh = 0;
+};
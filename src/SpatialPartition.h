@@ -10,12 +10,21 @@ template <typename TPayload>
 class SpatialPartition
 {
 public:
+    // Dedup state for multi cell IterateNearby, owned by the caller so concurrent queries don't share it.
+    // Payloads are stamped with the query generation, so only growth of the payload count allocates.
+    struct NearbyScratch
+    {
+        std::vector<uint32_t> Stamps;
+        uint32_t Generation = 0;
+    };
+
     void InitArea(Vector2 extents, int countX, int countY)
     {
         Extents = extents;
         CountX = countX;
         CountY = countY;
         mSparseCells.resize(CountX * CountY);
+        mCellBuckets.resize(CountX * CountY);
     }
 
     void Clear()
@@ -29,6 +38,91 @@ public:
         mInsertionAreas.clear();
     }
 
+    // Drops the incremental state as well, for when the payloads it tracks went away
+    void Reset()
+    {
+        Clear();
+        for (std::vector<uint32_t>& bucket : mCellBuckets) {
+            bucket.clear();
+        }
+        mFreeSlots.clear();
+        mBucketsDirty = false;
+    }
+
+    //-------Incremental mode: payloads keep a slot across bakes and only move when their cell footprint changes.
+    //-------Not to be mixed with InsertDeferred/FlushInsertions until the next Reset.
+
+    uint32_t Insert(TPayload payload, const Vector2& min, const Vector2& max)
+    {
+        const Area area = ComputeArea(min, max);
+        assert(area.MaxI - area.MinI < CountX && area.MaxJ - area.MinJ < CountY);
+
+        uint32_t handle;
+        if (mFreeSlots.empty()) {
+            handle = static_cast<uint32_t>(mPayloads.size());
+            mPayloads.push_back(payload);
+            mInsertionAreas.push_back(area);
+        } else {
+            handle = mFreeSlots.back();
+            mFreeSlots.pop_back();
+            mPayloads[handle] = payload;
+            mInsertionAreas[handle] = area;
+        }
+        AddToBuckets(handle, area);
+        return handle;
+    }
+
+    void Move(uint32_t handle, TPayload payload, const Vector2& min, const Vector2& max)
+    {
+        mPayloads[handle] = payload;
+        const Area area = ComputeArea(min, max);
+        const Area& current = mInsertionAreas[handle];
+        if (area.MinI == current.MinI && area.MinJ == current.MinJ && area.MaxI == current.MaxI &&
+            area.MaxJ == current.MaxJ) {
+            return;
+        }
+        assert(area.MaxI - area.MinI < CountX && area.MaxJ - area.MinJ < CountY);
+        RemoveFromBuckets(handle, current);
+        mInsertionAreas[handle] = area;
+        AddToBuckets(handle, area);
+    }
+
+    void Remove(uint32_t handle)
+    {
+        RemoveFromBuckets(handle, mInsertionAreas[handle]);
+        mFreeSlots.push_back(handle);
+    }
+
+    // Rebakes the cell lookup from the buckets, only if any footprint changed since the last bake
+    void FlushUpdates()
+    {
+        if (!mBucketsDirty) {
+            return;
+        }
+        mBucketsDirty = false;
+
+        // Packed cells ordered by their lowest slot, like FlushInsertions does, IteratePairs relies on it
+        mPackedCells.clear();
+        for (uint32_t cellID = 0; cellID < mCellBuckets.size(); ++cellID) {
+            if (!mCellBuckets[cellID].empty()) {
+                mPackedCells.push_back(cellID);
+            }
+        }
+        std::sort(mPackedCells.begin(), mPackedCells.end(), [this](uint32_t left, uint32_t right) {
+            return mCellBuckets[left].front() < mCellBuckets[right].front();
+        });
+
+        mCellLookup.resize(mPackedCells.size());
+        mPartition.clear();
+        for (uint32_t cellIndex = 0; cellIndex < mPackedCells.size(); ++cellIndex) {
+            const uint32_t cellID = mPackedCells[cellIndex];
+            const std::vector<uint32_t>& bucket = mCellBuckets[cellID];
+            mSparseCells[cellID] = cellIndex;
+            mCellLookup[cellIndex] = {static_cast<uint32_t>(mPartition.size()), static_cast<uint32_t>(bucket.size())};
+            mPartition.insert(mPartition.end(), bucket.begin(), bucket.end());
+        }
+    }
+
     void InsertDeferred(TPayload payload, const Vector2& min, const Vector2& max)
     {
         assert(min.x <= max.x);
@@ -36,7 +130,9 @@ public:
 
         mPayloads.push_back(payload);
 
-        mInsertionAreas.push_back(ComputeArea(min, max));
+        const Area area = ComputeArea(min, max);
+        assert(area.MaxI - area.MinI < CountX && area.MaxJ - area.MinJ < CountY);
+        mInsertionAreas.push_back(area);
     }
 
     void FlushInsertions()
@@ -131,13 +227,69 @@ public:
         }
     }
 
+    size_t PackedCellCount() const
+    {
+        return mPackedCells.size();
+    }
+
+    // Alternative to IteratePairs that is duplicate free by construction: a pair is only reported in the cell
+    // holding the min corner of the overlap of both areas. Needs no state, so it is const.
+    template <typename TPairAction>
+    void IteratePairsMinCorner(TPairAction&& pairAction) const
+    {
+        IteratePairsMinCorner(0, mPackedCells.size(), pairAction);
+    }
+
+    // Disjoint ranges of packed cells never report the same pair
+    template <typename TPairAction>
+    void IteratePairsMinCorner(size_t firstCell, size_t lastCell, TPairAction&& pairAction) const
+    {
+        for (size_t cellIndex = firstCell; cellIndex < lastCell; ++cellIndex) {
+            const uint32_t cellID = mPackedCells[cellIndex];
+            const int cellI = cellID % CountX;
+            const int cellJ = cellID / CountX;
+            const CellLookup cellLookup = mCellLookup[cellIndex];
+            for (uint32_t firstIt = 0; firstIt + 1 < cellLookup.Count; ++firstIt) {
+                const uint32_t firstItem = mPartition[cellLookup.First + firstIt];
+                const Area& firstArea = mInsertionAreas[firstItem];
+                for (uint32_t secondIt = firstIt + 1; secondIt < cellLookup.Count; ++secondIt) {
+                    const uint32_t secondItem = mPartition[cellLookup.First + secondIt];
+                    const Area& secondArea = mInsertionAreas[secondItem];
+                    const int overlapI = OverlapMin(firstArea.MinI, secondArea.MinI, cellI, CountX);
+                    const int overlapJ = OverlapMin(firstArea.MinJ, secondArea.MinJ, cellJ, CountY);
+                    if (Mod(overlapI, CountX) != cellI || Mod(overlapJ, CountY) != cellJ) {
+                        continue;
+                    }
+                    pairAction(mPayloads[firstItem], mPayloads[secondItem]);
+                }
+            }
+        }
+    }
+
     template <typename TNearAction>
     void IterateNearby(const Vector2& min, const Vector2& max, TNearAction&& nearAction)
     {
-        mNearbyPacked.clear();
-        mNearbySparse.resize(mPayloads.size());
+        IterateNearby(min, max, mNearbyScratch, std::forward<TNearAction>(nearAction));
+    }
 
+    // Read only on the partition, safe to call from several threads once FlushInsertions is done
+    template <typename TNearAction>
+    void IterateNearby(const Vector2& min, const Vector2& max, NearbyScratch& scratch, TNearAction&& nearAction) const
+    {
         const Area area = ComputeArea(min, max);
+        if (area.MinI == area.MaxI && area.MinJ == area.MaxJ) {
+            IterateCell(GetCellID(area.MinI, area.MinJ), nearAction);
+            return;
+        }
+
+        if (scratch.Stamps.size() < mPayloads.size()) {
+            scratch.Stamps.resize(mPayloads.size(), scratch.Generation);
+        }
+        scratch.Generation += 1;
+        if (scratch.Generation == 0) {
+            std::fill(scratch.Stamps.begin(), scratch.Stamps.end(), 0);
+            scratch.Generation = 1;
+        }
 
         auto areaCellIteration = [&](uint32_t cellID) {
             uint32_t cellIndex = mSparseCells[cellID];
@@ -148,17 +300,13 @@ public:
             const CellLookup lookup = mCellLookup[cellIndex];
             for (uint32_t it = lookup.First; it < lookup.First + lookup.Count; ++it) {
                 const uint32_t itemIndex = mPartition[it];
-                const uint32_t packedIndex = mNearbySparse[itemIndex];
-                bool alreadyIterated =
-                packedIndex < mNearbyPacked.size() && mNearbyPacked[packedIndex] == itemIndex;
-                if (alreadyIterated) {
+                if (scratch.Stamps[itemIndex] == scratch.Generation) {
                     continue;
                 }
                 if (nearAction(mPayloads[itemIndex])) {
                     return true;
                 }
-                mNearbySparse[itemIndex] = mNearbyPacked.size();
-                mNearbyPacked.push_back(itemIndex);
+                scratch.Stamps[itemIndex] = scratch.Generation;
             }
             return false;
         };
@@ -166,6 +314,14 @@ public:
         IterateArea(area, areaCellIteration);
     }
 
+    // A payload is listed at most once per cell, so point queries need no dedup state at all
+    template <typename TNearAction>
+    void IterateNearbyPoint(const Vector2& point, TNearAction&& nearAction) const
+    {
+        auto [i, j] = CellIntCoords(point);
+        IterateCell(GetCellID(i, j), nearAction);
+    }
+
 private:
     struct Area
     {
@@ -175,7 +331,7 @@ private:
         int MaxJ;
     };
 
-    inline Area ComputeArea(const Vector2& min, const Vector2& max)
+    inline Area ComputeArea(const Vector2& min, const Vector2& max) const
     {
         auto [minI, minJ] = CellIntCoords(min);
         auto [maxI, maxJ] = CellIntCoords(max);
@@ -195,7 +351,7 @@ private:
         }
     };
 
-    inline std::tuple<int, int> CellIntCoords(const Vector2& point)
+    inline std::tuple<int, int> CellIntCoords(const Vector2& point) const
     {
         float relativeX = point.x / Extents.x;
         float relativeY = point.y / Extents.y;
@@ -205,15 +361,69 @@ private:
                 static_cast<int>((1.f + relativeY) * CountY) - CountY};
     }
 
-    inline uint32_t GetCellID(const int i, const int j)
+    static inline int Mod(const int value, const int count)
+    {
+        return (value % count + count) % count;
+    }
+
+    // Min coordinate of the overlap of two ranges that both contain the wrapped coordinate cell.
+    // Ranges are narrower than the grid, so b's range is shifted to share a's unwrapped instance of cell.
+    static inline int OverlapMin(const int minA, const int minB, const int cell, const int count)
     {
-        int iMod = (i % CountX + CountX) % CountX;
-        int jMod = (j % CountY + CountY) % CountY;
-        return iMod + jMod * CountX;
+        const int instanceA = minA + Mod(cell - minA, count);
+        const int instanceB = minB + Mod(cell - minB, count);
+        return std::max(minA, minB + instanceA - instanceB);
+    }
+
+    inline uint32_t GetCellID(const int i, const int j) const
+    {
+        return Mod(i, CountX) + Mod(j, CountY) * CountX;
+    }
+
+    template <typename TNearAction>
+    bool IterateCell(uint32_t cellID, TNearAction&& nearAction) const
+    {
+        const uint32_t cellIndex = mSparseCells[cellID];
+        const bool cellExists = cellIndex < mPackedCells.size() && mPackedCells[cellIndex] == cellID;
+        if (!cellExists) {
+            return false;
+        }
+        const CellLookup lookup = mCellLookup[cellIndex];
+        for (uint32_t it = lookup.First; it < lookup.First + lookup.Count; ++it) {
+            if (nearAction(mPayloads[mPartition[it]])) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Buckets are kept sorted so baked cells list payloads in ascending order, as FlushInsertions does
+    void AddToBuckets(uint32_t handle, const Area& area)
+    {
+        auto addAction = [&](uint32_t cellID) {
+            std::vector<uint32_t>& bucket = mCellBuckets[cellID];
+            bucket.insert(std::lower_bound(bucket.begin(), bucket.end(), handle), handle);
+            return false;
+        };
+        IterateArea(area, addAction);
+        mBucketsDirty = true;
+    }
+
+    void RemoveFromBuckets(uint32_t handle, const Area& area)
+    {
+        auto removeAction = [&](uint32_t cellID) {
+            std::vector<uint32_t>& bucket = mCellBuckets[cellID];
+            auto it = std::lower_bound(bucket.begin(), bucket.end(), handle);
+            assert(it != bucket.end() && *it == handle);
+            bucket.erase(it);
+            return false;
+        };
+        IterateArea(area, removeAction);
+        mBucketsDirty = true;
     }
 
     template <typename TAction>
-    void IterateArea(const Area& area, TAction&& action)
+    void IterateArea(const Area& area, TAction&& action) const
     {
         assert(area.MinI <= CountX && area.MinJ <= CountY);
         assert(area.MaxI >= 0 && area.MaxJ >= 0);
@@ -244,9 +454,12 @@ private:
     std::vector<uint32_t> mPartition;
     std::vector<Area> mInsertionAreas;
 
+    std::vector<std::vector<uint32_t>> mCellBuckets; // Incremental mode only, indexed by cell ID
+    std::vector<uint32_t> mFreeSlots;
+    bool mBucketsDirty = false;
+
     std::vector<IndexPair> mPairAccumulator;
     std::vector<IndexPair> mPairAppend;
 
-    std::vector<uint32_t> mNearbyPacked;
-    std::vector<uint32_t> mNearbySparse;
+    NearbyScratch mNearbyScratch;
 };
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <stdint.h>
+
+// Lock-free multi producer, multi consumer FIFO with a fixed capacity (Vyukov's bounded queue).
+// Each slot carries a sequence number telling whether it is ready to be written or read for the current lap.
+template <typename T, size_t Capacity>
+class BoundedQueue final
+{
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    BoundedQueue()
+    {
+        for (size_t i = 0; i < Capacity; ++i) {
+            mSlots[i].Sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // Returns false when full
+    bool TryPush(T* item)
+    {
+        size_t position = mEnqueuePosition.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = mSlots[position & Mask];
+            const size_t sequence = slot.Sequence.load(std::memory_order_acquire);
+            const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (difference == 0) {
+                if (mEnqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    slot.Item = item;
+                    slot.Sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = mEnqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Returns null when empty
+    T* TryPop()
+    {
+        size_t position = mDequeuePosition.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = mSlots[position & Mask];
+            const size_t sequence = slot.Sequence.load(std::memory_order_acquire);
+            const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+            if (difference == 0) {
+                if (mDequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    T* item = slot.Item;
+                    slot.Sequence.store(position + Capacity, std::memory_order_release);
+                    return item;
+                }
+            } else if (difference < 0) {
+                return nullptr;
+            } else {
+                position = mDequeuePosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Approximate, only meant as a hint for idle threads
+    bool Empty() const
+    {
+        return mEnqueuePosition.load(std::memory_order_relaxed) <= mDequeuePosition.load(std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr size_t Mask = Capacity - 1;
+
+    struct Slot
+    {
+        std::atomic<size_t> Sequence;
+        T* Item;
+    };
+
+    alignas(64) std::array<Slot, Capacity> mSlots;
+    alignas(64) std::atomic<size_t> mEnqueuePosition = 0;
+    alignas(64) std::atomic<size_t> mDequeuePosition = 0;
+};
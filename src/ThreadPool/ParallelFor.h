@@ -0,0 +1,41 @@
+#pragma once
+
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// Splits [0, count) in chunks and runs them on the pool, the calling thread helps until all are done.
+// Tasks are stored in the given vector, which must not be shared with another RunChunks in flight.
+template <typename TChunkAction>
+void RunChunks(ThreadPool& threadPool,
+               std::vector<Task>& tasks,
+               size_t count,
+               size_t chunkSize,
+               TChunkAction&& chunkAction)
+{
+    const size_t chunks = (count + chunkSize - 1) / chunkSize;
+    if (chunks <= 1) {
+        if (chunks == 1) {
+            chunkAction(0, 0, count);
+        }
+        return;
+    }
+
+    std::atomic<size_t> pending = chunks;
+    tasks.clear();
+    for (size_t chunk = 0; chunk < chunks; ++chunk) {
+        tasks.emplace_back([&, chunk]() {
+            const size_t first = chunk * chunkSize;
+            chunkAction(chunk, first, std::min(count, first + chunkSize));
+            pending.fetch_sub(1, std::memory_order_release);
+        });
+    }
+    threadPool.PushTasks(tasks.begin(), tasks.end());
+    while (pending.load(std::memory_order_acquire) > 0) {
+        if (!threadPool.TryHelpOneTask()) {
+            std::this_thread::yield();
+        }
+    }
+}
@@ -0,0 +1,77 @@
+#include "TaskGraph.h"
+#include <cassert>
+
+uint32_t TaskGraph::AddNode(const char* name, AccessMask reads, AccessMask writes, std::function<void()> action)
+{
+    const uint32_t index = static_cast<uint32_t>(mNodes.size());
+    Node& node = mNodes.emplace_back();
+    node.Name = name;
+    node.Reads = reads;
+    node.Writes = writes;
+    node.Action = std::move(action);
+    node.PoolTask = [this, &node]() {
+        runNode(node);
+    };
+
+    for (uint32_t previousIndex = 0; previousIndex < index; ++previousIndex) {
+        Node& previous = mNodes[previousIndex];
+        const bool conflict = (previous.Writes & (reads | writes)) != 0 || (previous.Reads & writes) != 0;
+        if (conflict) {
+            previous.Successors.push_back(index);
+            node.PredecessorCount += 1;
+        }
+    }
+    return index;
+}
+
+void TaskGraph::Run(ThreadPool& threadPool)
+{
+    if (mNodes.empty()) {
+        return;
+    }
+    assert(mRemaining.load() == 0);
+    mThreadPool = &threadPool;
+    mRemaining.store(static_cast<uint32_t>(mNodes.size()), std::memory_order_relaxed);
+    for (Node& node : mNodes) {
+        node.PendingPredecessors.store(node.PredecessorCount, std::memory_order_relaxed);
+    }
+    for (Node& node : mNodes) {
+        if (node.PredecessorCount == 0) {
+            threadPool.PushTask(node.PoolTask);
+        }
+    }
+    while (mRemaining.load(std::memory_order_acquire) > 0) {
+        if (!threadPool.TryHelpOneTask()) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void TaskGraph::RunSerial()
+{
+    for (Node& node : mNodes) {
+        node.Action();
+    }
+}
+
+size_t TaskGraph::NodeCount() const
+{
+    return mNodes.size();
+}
+
+const char* TaskGraph::NodeName(uint32_t node) const
+{
+    return mNodes[node].Name;
+}
+
+void TaskGraph::runNode(Node& node)
+{
+    node.Action();
+    for (uint32_t successorIndex : node.Successors) {
+        Node& successor = mNodes[successorIndex];
+        if (successor.PendingPredecessors.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            mThreadPool->PushTask(successor.PoolTask);
+        }
+    }
+    mRemaining.fetch_sub(1, std::memory_order_acq_rel);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "ThreadPool.h"
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <stdint.h>
+#include <vector>
+
+// One bit per resource (component storage, shared container...) a node touches
+using AccessMask = uint64_t;
+
+// Nodes run in insertion order semantics: a node waits for every earlier node whose accesses conflict with its own
+// (a write against a read or a write), and nodes that don't conflict may run concurrently on the pool.
+class TaskGraph final
+{
+public:
+    uint32_t AddNode(const char* name, AccessMask reads, AccessMask writes, std::function<void()> action);
+
+    // The calling thread helps on the pool until all nodes are done
+    void Run(ThreadPool& threadPool);
+    // Insertion order on the calling thread, as reference for Run
+    void RunSerial();
+
+    size_t NodeCount() const;
+    const char* NodeName(uint32_t node) const;
+
+private:
+    struct Node
+    {
+        const char* Name;
+        AccessMask Reads;
+        AccessMask Writes;
+        std::function<void()> Action;
+        std::vector<uint32_t> Successors;
+        uint32_t PredecessorCount = 0;
+        std::atomic<uint32_t> PendingPredecessors = 0;
+        Task PoolTask;
+    };
+
+    void runNode(Node& node);
+
+    // Deque keeps node addresses stable, tasks are pushed by pointer
+    std::deque<Node> mNodes;
+    ThreadPool* mThreadPool = nullptr;
+    std::atomic<uint32_t> mRemaining = 0;
+};
@@ -1,13 +1,37 @@
 #include "ThreadPool.h"
 #include <cassert>
 
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+static inline void CpuRelax()
+{
+    _mm_pause();
+}
+#else
+static inline void CpuRelax()
+{}
+#endif
+
+// Lets pushes and helpers from a worker thread use that worker's own deque
+static thread_local const ThreadPool* CurrentPool = nullptr;
+static thread_local size_t CurrentWorker = 0;
+static thread_local uint32_t StealRandomState =
+static_cast<uint32_t>(std::hash<std::thread::id>()(std::this_thread::get_id())) | 1u;
+
+static constexpr size_t NoWorker = ~size_t(0);
+
 ThreadPool::ThreadPool(size_t threadCount) : ThreadCount(threadCount)
 {
+    mWorkers.reserve(ThreadCount);
+    for (size_t i = 0; i < ThreadCount; ++i) {
+        mWorkers.push_back(std::make_unique<Worker>());
+    }
+
     mThreads.reserve(ThreadCount);
     while (mThreads.size() < ThreadCount) {
-        auto taskProcess = [&](std::stop_token stopCondition) {
-            while (threadDoTask(stopCondition)) {
-            }
+        const size_t workerIndex = mThreads.size();
+        auto taskProcess = [this, workerIndex](std::stop_token stopCondition) {
+            workerProcess(workerIndex, stopCondition);
         };
         mThreads.emplace_back(taskProcess);
     };
@@ -18,61 +42,137 @@ ThreadPool::~ThreadPool()
     for (auto& thread : mThreads) {
         thread.request_stop();
     }
-    mTaskCondition.notify_all();
+    mWakeEpoch.fetch_add(1, std::memory_order_seq_cst);
+    mWakeEpoch.notify_all();
     mThreads.clear();
 }
 
 void ThreadPool::PushTask(Task& task)
 {
-    {
-        std::scoped_lock<std::mutex> lock(mTaskMutex);
-        mTaskQueue.push(&task);
-    }
-    mTaskCondition.notify_one();
+    pushOne(&task);
+    wakeWorkers(false);
 }
 
 void ThreadPool::PushTasks(std::vector<Task>::iterator first, std::vector<Task>::iterator last)
 {
-    {
-        std::scoped_lock<std::mutex> lock(mTaskMutex);
-        for (auto it = first; it != last; ++it) {
-            mTaskQueue.push(&*it);
-        }
+    for (auto it = first; it != last; ++it) {
+        pushOne(&*it);
     }
-    mTaskCondition.notify_all();
+    wakeWorkers(true);
 }
 
 bool ThreadPool::TryHelpOneTask()
 {
-    Task* task;
-    {
-        std::unique_lock<std::mutex> lock(mTaskMutex);
-        if (mTaskQueue.empty()) {
-            return false;
-        }
-        task = mTaskQueue.front();
-        mTaskQueue.pop();
+    const size_t workerIndex = CurrentPool == this ? CurrentWorker : NoWorker;
+    Task* task = findTask(workerIndex);
+    if (task == nullptr) {
+        return false;
     }
     (*task)();
     return true;
 }
 
-bool ThreadPool::threadDoTask(std::stop_token exitThreadCondition)
+void ThreadPool::pushOne(Task* task)
+{
+    if (CurrentPool == this && mWorkers[CurrentWorker]->Deque.Push(task)) {
+        return;
+    }
+    if (mInjectionQueue.TryPush(task)) {
+        return;
+    }
+    // Both full, the pool is saturated anyway
+    (*task)();
+}
+
+Task* ThreadPool::findTask(size_t workerIndex)
 {
-    Task* task;
-    {
-        std::unique_lock<std::mutex> lock(mTaskMutex);
-        mTaskCondition.wait(lock, [&]() {
-            return exitThreadCondition.stop_requested() || !mTaskQueue.empty();
-        });
-
-        if (exitThreadCondition.stop_requested() && mTaskQueue.empty()) {
-            return false;
+    if (workerIndex != NoWorker) {
+        if (Task* task = mWorkers[workerIndex]->Deque.Pop()) {
+            return task;
         }
+    }
+    if (Task* task = mInjectionQueue.TryPop()) {
+        return task;
+    }
 
-        task = mTaskQueue.front();
-        mTaskQueue.pop();
+    // Start stealing at a random victim so thieves spread out
+    const size_t workerCount = mWorkers.size();
+    if (workerCount == 0) {
+        return nullptr;
+    }
+    StealRandomState ^= StealRandomState << 13;
+    StealRandomState ^= StealRandomState >> 17;
+    StealRandomState ^= StealRandomState << 5;
+    const size_t firstVictim = StealRandomState % workerCount;
+    for (size_t i = 0; i < workerCount; ++i) {
+        const size_t victim = (firstVictim + i) % workerCount;
+        if (victim == workerIndex) {
+            continue;
+        }
+        if (Task* task = mWorkers[victim]->Deque.Steal()) {
+            return task;
+        }
+    }
+    return nullptr;
+}
+
+bool ThreadPool::hasQueuedTasks() const
+{
+    if (!mInjectionQueue.Empty()) {
+        return true;
+    }
+    for (const auto& worker : mWorkers) {
+        if (!worker->Deque.Empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::wakeWorkers(bool all)
+{
+    // Pairs with the fence in workerProcess: either the sleeper sees the task or we see the sleeper
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (mSleepers.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+    mWakeEpoch.fetch_add(1, std::memory_order_release);
+    if (all) {
+        mWakeEpoch.notify_all();
+    } else {
+        mWakeEpoch.notify_one();
+    }
+}
+
+void ThreadPool::workerProcess(size_t workerIndex, std::stop_token stopCondition)
+{
+    CurrentPool = this;
+    CurrentWorker = workerIndex;
+
+    while (true) {
+        Task* task = findTask(workerIndex);
+        for (uint32_t spin = 0; task == nullptr && spin < IdleSpins; ++spin) {
+            CpuRelax();
+            if ((spin & 63) == 63) {
+                task = findTask(workerIndex);
+            }
+        }
+        if (task != nullptr) {
+            (*task)();
+            continue;
+        }
+
+        const uint32_t epoch = mWakeEpoch.load(std::memory_order_acquire);
+        mSleepers.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const bool queued = hasQueuedTasks();
+        if (!queued && !stopCondition.stop_requested()) {
+            mWakeEpoch.wait(epoch, std::memory_order_acquire);
+        }
+        mSleepers.fetch_sub(1, std::memory_order_relaxed);
+
+        if (!queued && stopCondition.stop_requested() && !hasQueuedTasks()) {
+            return;
+        }
     }
-    (*task)();
-    return true;
 }
@@ -1,14 +1,17 @@
 #pragma once
 
-#include <condition_variable>
+#include "BoundedQueue.h"
+#include "WorkStealingDeque.h"
+#include <atomic>
 #include <functional>
-#include <mutex>
-#include <queue>
+#include <memory>
 #include <thread>
 #include <vector>
 
 typedef std::function<void()> Task;
 
+// Work-stealing pool: each worker owns a deque, tasks pushed from outside the pool go through a shared lock-free
+// injection queue. Idle workers steal, spin for a while and then park on an atomic until new work is pushed.
 class ThreadPool final
 {
 public:
@@ -23,12 +26,26 @@ public:
     bool TryHelpOneTask();
 
 private:
-    inline bool threadDoTask(std::stop_token stopCondition);
-    inline void joinThreads();
+    static constexpr size_t DequeCapacity = 4096;
+    static constexpr size_t InjectionCapacity = 8192;
+    static constexpr uint32_t IdleSpins = 2048;
 
-    std::mutex mTaskMutex;
-    std::condition_variable mTaskCondition;
+    struct Worker
+    {
+        WorkStealingDeque<Task, DequeCapacity> Deque;
+    };
+
+    inline void workerProcess(size_t workerIndex, std::stop_token stopCondition);
+    inline void pushOne(Task* task);
+    inline Task* findTask(size_t workerIndex);
+    inline bool hasQueuedTasks() const;
+    inline void wakeWorkers(bool all);
+
+    std::vector<std::unique_ptr<Worker>> mWorkers;
+    BoundedQueue<Task, InjectionCapacity> mInjectionQueue;
+
+    alignas(64) std::atomic<uint32_t> mWakeEpoch = 0;
+    alignas(64) std::atomic<uint32_t> mSleepers = 0;
 
     std::vector<std::jthread> mThreads;
-    std::queue<Task*> mTaskQueue;
 };
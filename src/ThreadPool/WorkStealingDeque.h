@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <stdint.h>
+
+// Chase-Lev deque with a fixed capacity: the owner thread pushes and pops at the bottom, any thread steals from the
+// top. Orderings follow "Correct and Efficient Work-Stealing for Weak Memory Models" (Le et al., 2013).
+template <typename T, size_t Capacity>
+class WorkStealingDeque final
+{
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    // Owner only, returns false when full
+    bool Push(T* item)
+    {
+        const int64_t bottom = mBottom.load(std::memory_order_relaxed);
+        const int64_t top = mTop.load(std::memory_order_acquire);
+        if (bottom - top >= static_cast<int64_t>(Capacity)) {
+            return false;
+        }
+        mItems[bottom & Mask].store(item, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        mBottom.store(bottom + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Owner only, takes the most recently pushed item
+    T* Pop()
+    {
+        const int64_t bottom = mBottom.load(std::memory_order_relaxed) - 1;
+        mBottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = mTop.load(std::memory_order_relaxed);
+        if (top > bottom) {
+            mBottom.store(bottom + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        T* item = mItems[bottom & Mask].load(std::memory_order_relaxed);
+        if (top == bottom) {
+            // Last item, race the thieves for it
+            if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                item = nullptr;
+            }
+            mBottom.store(bottom + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    // Any thread, takes the oldest item. Returns null when empty or when losing a race against another thread.
+    T* Steal()
+    {
+        int64_t top = mTop.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t bottom = mBottom.load(std::memory_order_acquire);
+        if (top >= bottom) {
+            return nullptr;
+        }
+        T* item = mItems[top & Mask].load(std::memory_order_relaxed);
+        if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return item;
+    }
+
+    bool Empty() const
+    {
+        return mBottom.load(std::memory_order_relaxed) <= mTop.load(std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr int64_t Mask = Capacity - 1;
+
+    alignas(64) std::atomic<int64_t> mTop = 0;
+    alignas(64) std::atomic<int64_t> mBottom = 0;
+    alignas(64) std::array<std::atomic<T*>, Capacity> mItems = {};
+};
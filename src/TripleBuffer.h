@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <stdint.h>
+#include <stop_token>
+
+// Single producer, single consumer handoff where the consumer always gets the latest published value.
+// The producer never waits: it writes into its own buffer and swaps it with the shared middle one on publish.
+// The consumer swaps its buffer with the middle one only when a fresh value was published since its last acquire.
+template <typename T>
+class TripleBuffer final
+{
+public:
+    //-------Producer side
+
+    T& WriteBuffer()
+    {
+        return mBuffers[mWriteIndex];
+    }
+
+    void Publish()
+    {
+        const uint32_t previous = mMiddle.exchange(mWriteIndex | FreshBit, std::memory_order_acq_rel);
+        mWriteIndex = previous & IndexMask;
+        mPublishCount.fetch_add(1, std::memory_order_release);
+        mPublishCount.notify_one();
+    }
+
+    //-------Consumer side
+
+    bool TryAcquire()
+    {
+        if ((mMiddle.load(std::memory_order_relaxed) & FreshBit) == 0) {
+            return false;
+        }
+        const uint32_t previous = mMiddle.exchange(mReadIndex, std::memory_order_acq_rel);
+        mReadIndex = previous & IndexMask;
+        return true;
+    }
+
+    // Blocks until a fresh buffer is acquired, returns false when stopped (request the stop, then Interrupt)
+    bool WaitAcquire(const std::stop_token& stopToken)
+    {
+        const uint32_t seenCount = mPublishCount.load(std::memory_order_acquire);
+        if (stopToken.stop_requested()) {
+            return false;
+        }
+        if (TryAcquire()) {
+            return true;
+        }
+        mPublishCount.wait(seenCount, std::memory_order_acquire);
+        return TryAcquire();
+    }
+
+    const T& ReadBuffer() const
+    {
+        return mBuffers[mReadIndex];
+    }
+
+    // Wakes a consumer blocked in WaitAcquire, so it can see its stop request
+    void Interrupt()
+    {
+        mPublishCount.fetch_add(1, std::memory_order_release);
+        mPublishCount.notify_all();
+    }
+
+private:
+    static constexpr uint32_t IndexMask = 0x3;
+    static constexpr uint32_t FreshBit = 0x4;
+
+    std::array<T, 3> mBuffers;
+    uint32_t mWriteIndex = 0;
+    uint32_t mReadIndex = 1;
+    std::atomic<uint32_t> mMiddle = 2;
+    std::atomic<uint32_t> mPublishCount = 0;
+};